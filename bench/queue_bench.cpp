@@ -0,0 +1,106 @@
+// Compares dap::Queue with the previous std::vector + mutex implementation under the process output workload: a
+// reader thread pushing chunks of output, a consumer popping them with a timeout (as StdoutTransport did).
+//
+// Usage: queue_bench [chunks] [chunk size]
+
+#include "dap/Queue.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+/// the implementation dap::Queue replaced
+template <typename T>
+class LegacyQueue
+{
+    std::vector<T> Q;
+    std::mutex mutex_lock;
+    std::condition_variable cv;
+
+public:
+    bool empty() const { return Q.empty(); }
+
+    void push(T o)
+    {
+        std::unique_lock<std::mutex> locker(mutex_lock);
+        Q.emplace_back(o);
+        cv.notify_all();
+    }
+
+    std::optional<T> pop(const std::chrono::milliseconds& ms)
+    {
+        std::unique_lock<std::mutex> locker(mutex_lock);
+        if (cv.wait_for(locker, ms, [this]() { return !Q.empty(); })) {
+            if (Q.empty()) {
+                return {};
+            }
+            T o = (*Q.begin());
+            Q.erase(Q.begin());
+            return o;
+        }
+        return {};
+    }
+};
+
+/// push `chunks` chunks from a producer thread while the consumer pops them. With `burst`, the producer runs ahead
+/// and the consumer starts only once everything was queued (a consumer that fell behind)
+template <typename QueueType>
+double Run(QueueType& queue, size_t chunks, size_t chunk_size, bool burst)
+{
+    std::string chunk(chunk_size, 'x');
+    auto start = std::chrono::steady_clock::now();
+    std::thread producer([&]() {
+        for (size_t i = 0; i < chunks; ++i) {
+            queue.push(chunk);
+        }
+    });
+    if (burst) {
+        producer.join();
+    }
+
+    size_t received = 0;
+    size_t bytes = 0;
+    while (received < chunks) {
+        auto item = queue.pop(std::chrono::milliseconds(5));
+        if (item.has_value()) {
+            bytes += item->size();
+            ++received;
+        }
+    }
+    if (!burst) {
+        producer.join();
+    }
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    if (bytes != chunks * chunk_size) {
+        fprintf(stderr, "data mismatch\n");
+        exit(1);
+    }
+    return elapsed.count();
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    size_t chunks = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 20000;
+    size_t chunk_size = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1024;
+
+    printf("%zu chunks of %zu bytes\n", chunks, chunk_size);
+    printf("%-10s %14s %14s\n", "workload", "legacy (ms)", "dap::Queue (ms)");
+    for (bool burst : { false, true }) {
+        LegacyQueue<std::string> legacy;
+        // the burst workload needs room for everything
+        dap::Queue<std::string> queue(burst ? chunks : 1024);
+        double legacy_ms = Run(legacy, chunks, chunk_size, burst);
+        double queue_ms = Run(queue, chunks, chunk_size, burst);
+        printf("%-10s %14.1f %14.1f\n", burst ? "burst" : "streaming", legacy_ms, queue_ms);
+    }
+    return 0;
+}
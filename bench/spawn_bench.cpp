@@ -0,0 +1,170 @@
+// Measures adapter launch latency: the time from starting a process with redirected stdio until it has exited,
+// using the previous fork() + close() loop launcher and the posix_spawn() launcher UnixProcess uses now. The parent
+// mimics a large IDE: it raises its descriptor limit and touches a large heap before spawning.
+//
+// Usage: spawn_bench [launches] [heap MB] [command]
+
+#ifdef _WIN32
+#include <cstdio>
+
+int main()
+{
+    printf("spawn_bench: POSIX only\n");
+    return 0;
+}
+#else
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <spawn.h>
+#include <string>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+#ifdef __APPLE__
+#include <crt_externs.h>
+#endif
+
+namespace
+{
+struct Pipes {
+    int in[2];
+    int out[2];
+    int err[2];
+
+    bool Open()
+    {
+        for (int* p : { in, out, err }) {
+            if (::pipe(p) != 0) {
+                return false;
+            }
+            ::fcntl(p[0], F_SETFD, FD_CLOEXEC);
+            ::fcntl(p[1], F_SETFD, FD_CLOEXEC);
+        }
+        return true;
+    }
+
+    void CloseChildEnds()
+    {
+        ::close(in[0]);
+        ::close(out[1]);
+        ::close(err[1]);
+    }
+
+    void CloseParentEnds()
+    {
+        ::close(in[1]);
+        ::close(out[0]);
+        ::close(err[0]);
+    }
+};
+
+/// the launcher UnixProcess used before: fork, close every possible descriptor, build argv in the child
+pid_t LegacySpawn(const std::vector<std::string>& args, Pipes& pipes)
+{
+    pid_t pid = ::fork();
+    if (pid == 0) {
+        ::dup2(pipes.in[0], STDIN_FILENO);
+        ::dup2(pipes.out[1], STDOUT_FILENO);
+        ::dup2(pipes.err[1], STDERR_FILENO);
+        const int fd_max = (sysconf(_SC_OPEN_MAX) != -1 ? sysconf(_SC_OPEN_MAX) : FD_SETSIZE);
+        for (int fd = 3; fd < fd_max; fd++) {
+            ::close(fd);
+        }
+        char** argv = new char*[args.size() + 1];
+        for (size_t i = 0; i < args.size(); ++i) {
+            argv[i] = new char[args[i].length() + 1];
+            strcpy(argv[i], args[i].c_str());
+        }
+        argv[args.size()] = nullptr;
+        ::execvp(argv[0], argv);
+        _exit(127);
+    }
+    return pid;
+}
+
+/// the launcher UnixProcess uses now
+pid_t PosixSpawn(const std::vector<std::string>& args, Pipes& pipes)
+{
+    std::vector<char*> argv;
+    for (const std::string& arg : args) {
+        argv.push_back(const_cast<char*>(arg.c_str()));
+    }
+    argv.push_back(nullptr);
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, pipes.in[0], STDIN_FILENO);
+    posix_spawn_file_actions_adddup2(&actions, pipes.out[1], STDOUT_FILENO);
+    posix_spawn_file_actions_adddup2(&actions, pipes.err[1], STDERR_FILENO);
+    posix_spawnattr_t attr;
+    posix_spawnattr_init(&attr);
+#ifdef __APPLE__
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_CLOEXEC_DEFAULT);
+    char** envp = *_NSGetEnviron();
+#else
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 34)
+    posix_spawn_file_actions_addclosefrom_np(&actions, 3);
+#endif
+    char** envp = environ;
+#endif
+    pid_t pid = -1;
+    int rc = ::posix_spawnp(&pid, argv[0], &actions, &attr, argv.data(), envp);
+    posix_spawnattr_destroy(&attr);
+    posix_spawn_file_actions_destroy(&actions);
+    return rc == 0 ? pid : -1;
+}
+
+template <typename Launcher>
+double Run(Launcher launch, const std::vector<std::string>& args, size_t launches)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < launches; ++i) {
+        Pipes pipes;
+        if (!pipes.Open()) {
+            perror("pipe");
+            exit(1);
+        }
+        pid_t pid = launch(args, pipes);
+        pipes.CloseChildEnds();
+        if (pid == -1) {
+            fprintf(stderr, "failed to start %s\n", args[0].c_str());
+            exit(1);
+        }
+        int status = 0;
+        ::waitpid(pid, &status, 0);
+        pipes.CloseParentEnds();
+    }
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / launches;
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    size_t launches = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200;
+    size_t heap_mb = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 512;
+    std::vector<std::string> args = { argc > 3 ? argv[3] : "true" };
+
+    // an IDE typically runs with a raised descriptor limit and a large, resident heap
+    rlimit limit = {};
+    if (::getrlimit(RLIMIT_NOFILE, &limit) == 0) {
+        limit.rlim_cur = limit.rlim_max;
+        ::setrlimit(RLIMIT_NOFILE, &limit);
+    }
+    std::vector<char> heap(heap_mb << 20);
+    for (size_t i = 0; i < heap.size(); i += 4096) {
+        heap[i] = 1;
+    }
+
+    printf("%zu launches of '%s', %zu MB heap, descriptor limit %ld\n", launches, args[0].c_str(), heap_mb,
+           sysconf(_SC_OPEN_MAX));
+    printf("%-14s %14s\n", "launcher", "latency (ms)");
+    printf("%-14s %14.3f\n", "fork + close", Run(LegacySpawn, args, launches));
+    printf("%-14s %14.3f\n", "posix_spawn", Run(PosixSpawn, args, launches));
+    return 0;
+}
+#endif
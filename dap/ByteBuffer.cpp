@@ -0,0 +1,82 @@
+#include "ByteBuffer.hpp"
+
+#include <cstring>
+
+namespace
+{
+constexpr size_t kMinCapacity = 4096;
+}
+
+namespace dap
+{
+ByteBuffer::ByteBuffer(ByteBuffer&& other) { *this = std::move(other); }
+
+ByteBuffer& ByteBuffer::operator=(ByteBuffer&& other)
+{
+    if (this == &other) {
+        return *this;
+    }
+    m_data = std::move(other.m_data);
+    m_capacity = other.m_capacity;
+    m_readPos = other.m_readPos;
+    m_writePos = other.m_writePos;
+    other.m_capacity = other.m_readPos = other.m_writePos = 0;
+    return *this;
+}
+
+void ByteBuffer::Consume(size_t count)
+{
+    if (count >= ReadableBytes()) {
+        // everything was read, rewind both cursors for free
+        Clear();
+    } else {
+        m_readPos += count;
+    }
+}
+
+void ByteBuffer::Grow(size_t minFree)
+{
+    size_t readable = ReadableBytes();
+    // +1 for the spare byte that allows placing a terminator past the last readable byte
+    size_t required = readable + minFree + 1;
+    if (required <= m_capacity && m_readPos >= readable) {
+        // the consumed prefix is larger than the data we need to move, compact in place
+        std::memmove(m_data.get(), ReadPtr(), readable);
+        m_readPos = 0;
+        m_writePos = readable;
+        return;
+    }
+
+    size_t new_capacity = m_capacity < kMinCapacity ? kMinCapacity : m_capacity;
+    while (new_capacity < required) {
+        new_capacity *= 2;
+    }
+
+    std::unique_ptr<char[]> data(new char[new_capacity]);
+    if (readable) {
+        std::memcpy(data.get(), ReadPtr(), readable);
+    }
+    m_data = std::move(data);
+    m_capacity = new_capacity;
+    m_readPos = 0;
+    m_writePos = readable;
+}
+
+char* ByteBuffer::PrepareWrite(size_t minFree)
+{
+    if (WritableBytes() < minFree || m_capacity == 0) {
+        Grow(minFree);
+    }
+    return m_data.get() + m_writePos;
+}
+
+void ByteBuffer::Append(const char* data, size_t len)
+{
+    if (len == 0) {
+        return;
+    }
+    char* p = PrepareWrite(len);
+    std::memcpy(p, data, len);
+    Commit(len);
+}
+} // namespace dap
@@ -0,0 +1,111 @@
+#ifndef DAP_BYTEBUFFER_HPP
+#define DAP_BYTEBUFFER_HPP
+
+#include "dap_exports.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <string_view>
+
+namespace dap
+{
+/// A growable byte buffer with separate read and write cursors.
+///
+/// Data is appended at the write cursor and consumed from the read cursor, so removing a message from the front of
+/// the buffer is O(1). The unread region is moved back to the start of the storage only when the writer runs out of
+/// room *and* the consumed prefix is at least as large as the unread region, which keeps the total number of bytes
+/// moved proportional to the number of bytes consumed.
+///
+/// The storage always keeps one spare byte past the write cursor, so callers may temporarily place a NULL terminator
+/// right after any readable range (see `Terminate()` / `Restore()`)
+class WXDLLIMPEXP_DAP ByteBuffer
+{
+    std::unique_ptr<char[]> m_data;
+    size_t m_capacity = 0;
+    size_t m_readPos = 0;
+    size_t m_writePos = 0;
+
+protected:
+    void Grow(size_t minFree);
+
+public:
+    ByteBuffer() {}
+    ~ByteBuffer() {}
+
+    ByteBuffer(ByteBuffer&& other);
+    ByteBuffer& operator=(ByteBuffer&& other);
+    ByteBuffer(const ByteBuffer&) = delete;
+    ByteBuffer& operator=(const ByteBuffer&) = delete;
+
+    /**
+     * @brief pointer to the first unread byte
+     */
+    const char* ReadPtr() const { return m_data.get() + m_readPos; }
+    char* ReadPtr() { return m_data.get() + m_readPos; }
+
+    /**
+     * @brief number of bytes available for reading
+     */
+    size_t ReadableBytes() const { return m_writePos - m_readPos; }
+
+    /**
+     * @brief is there anything to read?
+     */
+    bool IsEmpty() const { return m_writePos == m_readPos; }
+
+    /**
+     * @brief return a view of the unread bytes. The view is invalidated by any non-const call
+     */
+    std::string_view View() const { return { ReadPtr(), ReadableBytes() }; }
+
+    /**
+     * @brief mark `count` bytes as read
+     */
+    void Consume(size_t count);
+
+    /**
+     * @brief make sure there are at least `minFree` writable bytes past the write cursor
+     * and return a pointer to them. Call `Commit()` with the number of bytes actually written
+     */
+    char* PrepareWrite(size_t minFree);
+
+    /**
+     * @brief number of bytes that can be written without re-allocating
+     */
+    size_t WritableBytes() const { return m_capacity == 0 ? 0 : m_capacity - m_writePos - 1; }
+
+    /**
+     * @brief advance the write cursor by `count` bytes previously written via `PrepareWrite()`
+     */
+    void Commit(size_t count) { m_writePos += count; }
+
+    /**
+     * @brief append `len` bytes
+     */
+    void Append(const char* data, size_t len);
+    void Append(std::string_view data) { Append(data.data(), data.length()); }
+
+    /**
+     * @brief discard everything (the storage is kept)
+     */
+    void Clear() { m_readPos = m_writePos = 0; }
+
+    /**
+     * @brief place a NULL terminator `offset` bytes past the read cursor and return the byte that was overwritten.
+     * `offset` must be lower or equal to `ReadableBytes()`. Use `Restore()` to put the original byte back
+     */
+    char Terminate(size_t offset)
+    {
+        char* p = ReadPtr() + offset;
+        char saved = *p;
+        *p = 0;
+        return saved;
+    }
+
+    /**
+     * @brief undo a previous call to `Terminate()`
+     */
+    void Restore(size_t offset, char saved) { ReadPtr()[offset] = saved; }
+};
+} // namespace dap
+#endif // DAP_BYTEBUFFER_HPP
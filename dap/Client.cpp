@@ -10,22 +10,78 @@
 
 #include <iostream>
 #include <thread>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 #include <wx/ffile.h>
 #include <wx/filename.h>
 #include <wx/msgdlg.h>
 
+///----------------------------------------------
+/// Transport
+///----------------------------------------------
+
+bool dap::Transport::Read(ByteBuffer& buffer, int msTimeout)
+{
+    std::string content;
+    if (!Read(content, msTimeout)) {
+        return false;
+    }
+    buffer.Append(content);
+    return true;
+}
+
+size_t dap::Transport::SendBatch(const std::string_view* buffers, size_t count)
+{
+    size_t total = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (buffers[i].empty()) {
+            continue;
+        }
+        size_t written = Send(std::string{ buffers[i] });
+        total += written;
+        if (written < buffers[i].size()) {
+            break;
+        }
+    }
+    return total;
+}
+
 ///----------------------------------------------
 /// Socket
 ///----------------------------------------------
 
-dap::SocketTransport::SocketTransport() { m_socket = new SocketClient(); }
+dap::SocketTransport::SocketTransport()
+{
+    m_socket = new SocketClient();
+    try {
+        m_interrupter.reset(new Interrupter());
+    } catch (Exception& e) {
+        // not fatal: the reader thread falls back to polling with a timeout
+        LOG_ERROR() << e.What() << endl;
+    }
+}
 
 dap::SocketTransport::~SocketTransport()
 {
+    for (auto& outgoing : m_sendQueue) {
+        CloseDescriptors(outgoing);
+    }
     // delete the socket
     wxDELETE(m_socket);
 }
 
+void dap::SocketTransport::CloseDescriptors(Outgoing& outgoing)
+{
+#ifndef _WIN32
+    for (int fd : outgoing.fds) {
+        ::close(fd);
+    }
+#endif
+    outgoing.fds.clear();
+}
+
 bool dap::SocketTransport::Connect(const std::string& connection_string, int timeoutSeconds)
 {
     long loops = timeoutSeconds;
@@ -45,34 +101,210 @@ bool dap::SocketTransport::Connect(const std::string& connection_string, int tim
 }
 
 bool dap::SocketTransport::Read(std::string& buffer, int msTimeout)
+{
+    ByteBuffer content;
+    bool success = Read(content, msTimeout);
+    buffer.assign(content.ReadPtr(), content.ReadableBytes());
+    return success;
+}
+
+void dap::SocketTransport::Interrupt()
+{
+    if (m_interrupter) {
+        m_interrupter->Signal();
+    }
+}
+
+bool dap::SocketTransport::Read(ByteBuffer& buffer, int msTimeout)
 {
     try {
-        buffer.clear();
-        if (m_socket->SelectReadMS(msTimeout) == Socket::kTimeout) {
-            buffer.clear();
+        // write whatever is queued, then wait for data, for the queue to become writable or for an interrupt
+        if (!Flush()) {
+            return false;
+        }
+
+        pollfd fds[2] = {};
+        fds[0].fd = m_socket->GetSocket();
+        fds[0].events = POLLIN | (GetPendingBytes() ? POLLOUT : 0);
+        size_t count = 1;
+        if (m_interrupter) {
+            fds[1].fd = m_interrupter->GetHandle();
+            fds[1].events = POLLIN;
+            count = 2;
+        }
+
+        int rc = Socket::Poll(fds, count, msTimeout);
+        if (rc < 0) {
+            throw Exception("SelectRead failed: " + Socket::error());
+        } else if (rc == 0) {
+            // timeout
             return true;
-        } else {
-            // success
-            if (m_socket->Read(buffer) != Socket::kSuccess) {
-                return false;
+        }
+
+        if (m_interrupter && fds[1].revents) {
+            m_interrupter->Clear();
+        }
+        if (fds[0].revents & ~POLLOUT) {
+            // readable, hung up or in error: let the read report it
+            size_t bytes_read = 0;
+            m_socket->Read(buffer, bytes_read);
+        }
+        // on POLLOUT the queue is flushed by the next call
+        return true;
+    } catch (Exception& e) {
+        LOG_ERROR() << e.What() << endl;
+        return false;
+    }
+}
+
+void dap::SocketTransport::DoFlush()
+{
+    std::string_view views[Socket::kMaxSendBuffers];
+    while (!m_sendQueue.empty()) {
+        // descriptors go with the first byte of a write, so a buffer carrying some starts a new write
+        size_t count = 0;
+        for (auto iter = m_sendQueue.begin(); iter != m_sendQueue.end() && count < Socket::kMaxSendBuffers; ++iter) {
+            if (count && !iter->fds.empty()) {
+                break;
             }
-            return true;
+            views[count++] = iter->data;
+        }
+        views[0].remove_prefix(m_sendOffset);
+
+        Outgoing& front = m_sendQueue.front();
+#ifdef _WIN32
+        size_t written = m_socket->SendSome(views, count);
+#else
+        size_t written = front.fds.empty() ? m_socket->SendSome(views, count)
+                                           : m_socket->SendSome(views, count, front.fds);
+#endif
+        if (written == 0) {
+            // the socket is full
+            break;
+        }
+        CloseDescriptors(front);
+        m_pendingBytes -= written;
+        written += m_sendOffset;
+        while (!m_sendQueue.empty() && written >= m_sendQueue.front().data.length()) {
+            written -= m_sendQueue.front().data.length();
+            m_sendQueue.pop_front();
         }
+        m_sendOffset = written;
+    }
+
+    if (m_aboveHighWater && m_pendingBytes < m_highWaterMark) {
+        m_aboveHighWater = false;
+    }
+}
+
+bool dap::SocketTransport::Flush()
+{
+    if (m_sendFailed.load()) {
+        return false;
+    }
+    if (GetPendingBytes() == 0) {
+        return true;
+    }
+
+    std::lock_guard<std::mutex> lock{ m_sendLock };
+    try {
+        DoFlush();
     } catch (Exception& e) {
         LOG_ERROR() << e.What() << endl;
+        m_sendFailed.store(true);
         return false;
     }
-    return false;
+    return true;
 }
 
 size_t dap::SocketTransport::Send(const std::string& buffer)
 {
+    std::string_view view{ buffer };
+    return SendBatch(&view, 1);
+}
+
+size_t dap::SocketTransport::SendBatch(const std::string_view* buffers, size_t count)
+{
+    if (m_sendFailed.load()) {
+        return 0;
+    }
+
+    std::unique_lock<std::mutex> lock{ m_sendLock };
+    size_t total = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (!buffers[i].empty()) {
+            m_sendQueue.push_back({ std::string{ buffers[i] }, {} });
+            total += buffers[i].size();
+        }
+    }
+    if (total == 0) {
+        return 0;
+    }
+    return SendQueued(lock, total);
+}
+
+#ifndef _WIN32
+size_t dap::SocketTransport::SendWithDescriptors(std::string_view buffer, const std::vector<int>& fds)
+{
+    if (m_sendFailed.load() || buffer.empty() || fds.size() > Socket::kMaxDescriptors) {
+        return 0;
+    }
+
+    // the caller may close its descriptors as soon as we return, while ours wait in the queue
+    Outgoing outgoing{ std::string{ buffer }, {} };
+    for (int fd : fds) {
+        int copy = ::fcntl(fd, F_DUPFD_CLOEXEC, 0);
+        if (copy < 0) {
+            LOG_ERROR() << "SendWithDescriptors: failed to duplicate descriptor: " << Socket::error() << endl;
+            CloseDescriptors(outgoing);
+            return 0;
+        }
+        outgoing.fds.push_back(copy);
+    }
+
+    std::unique_lock<std::mutex> lock{ m_sendLock };
+    m_sendQueue.push_back(std::move(outgoing));
+    return SendQueued(lock, buffer.size());
+}
+#endif
+
+size_t dap::SocketTransport::SendQueued(std::unique_lock<std::mutex>& lock, size_t bytes)
+{
+    m_pendingBytes += bytes;
     try {
-        m_socket->Send(buffer);
-        return buffer.length();
+        // when nothing else is queued this writes the buffer right away, in the common case no other thread
+        // gets involved
+        DoFlush();
     } catch (Exception& e) {
+        LOG_ERROR() << e.What() << endl;
+        m_sendFailed.store(true);
         return 0;
     }
+
+    high_water_cb callback;
+    size_t pending = m_pendingBytes.load();
+    if (m_highWaterMark && !m_aboveHighWater && pending > m_highWaterMark) {
+        m_aboveHighWater = true;
+        callback = m_onHighWater;
+    }
+    lock.unlock();
+
+    if (pending) {
+        // let the reader thread wait for the socket to become writable
+        Interrupt();
+    }
+    if (callback) {
+        callback(pending);
+    }
+    return bytes;
+}
+
+void dap::SocketTransport::SetHighWaterMark(size_t bytes, high_water_cb callback)
+{
+    std::lock_guard<std::mutex> lock{ m_sendLock };
+    m_highWaterMark = bytes;
+    m_onHighWater = std::move(callback);
+    m_aboveHighWater = false;
 }
 
 ///----------------------------------------------
@@ -90,14 +322,51 @@ bool dap::StdoutTransport::Execute(const std::vector<wxString>& command, const w
         command_string << DapStringUtils::WrapWithQuotes(cmd) << " ";
     }
 
-    m_process = dap::ExecuteProcess(command_string, workingDirectory);
+#ifndef _WIN32
+    try {
+        m_interrupter.reset(new Interrupter());
+    } catch (Exception& e) {
+        LOG_ERROR() << e.What() << endl;
+    }
+#endif
+
+    // when we can poll the pipes ourselves, the Process reader threads are not needed
+    m_process = dap::ExecuteProcess(command_string, workingDirectory, m_interrupter == nullptr);
+    if (m_process && m_interrupter) {
+        if (m_process->GetStdoutFd() == -1) {
+            m_interrupter.reset();
+            m_process->StartThreads();
+        } else {
+#ifndef _WIN32
+            for (int fd : { m_process->GetStdoutFd(), m_process->GetStderrFd() }) {
+                if (fd != -1) {
+                    ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+                }
+            }
+#endif
+        }
+    }
     return IsAlive();
 }
 
 bool dap::StdoutTransport::IsAlive() const { return m_process != nullptr && m_process->IsAlive(); }
 
+void dap::StdoutTransport::Interrupt()
+{
+    if (m_interrupter) {
+        m_interrupter->Signal();
+    }
+}
+
 bool dap::StdoutTransport::Read(std::string& buffer, int msTimeout)
 {
+    if (m_interrupter) {
+        ByteBuffer content;
+        bool success = DoReadPipes(content, msTimeout);
+        buffer.assign(content.ReadPtr(), content.ReadableBytes());
+        return success;
+    }
+
     if (!IsAlive()) {
         // process terminated
         wxDELETE(m_process);
@@ -121,18 +390,126 @@ bool dap::StdoutTransport::Read(std::string& buffer, int msTimeout)
     return true;
 }
 
+bool dap::StdoutTransport::Read(ByteBuffer& buffer, int msTimeout)
+{
+    if (m_interrupter) {
+        return DoReadPipes(buffer, msTimeout);
+    }
+    return Transport::Read(buffer, msTimeout);
+}
+
+bool dap::StdoutTransport::DoReadPipes(ByteBuffer& buffer, int msTimeout)
+{
+#ifdef _WIN32
+    wxUnusedVar(buffer);
+    wxUnusedVar(msTimeout);
+    return false;
+#else
+    if (!m_process) {
+        return false;
+    }
+
+    pollfd fds[4] = {};
+    fds[0].fd = m_process->GetStdoutFd();
+    fds[0].events = POLLIN;
+    fds[1].fd = m_stderrOpen ? m_process->GetStderrFd() : -1; // negative descriptors are ignored by poll()
+    fds[1].events = POLLIN;
+    fds[2].fd = m_interrupter->GetHandle();
+    fds[2].events = POLLIN;
+    // the process exit: the stdout pipe may outlive it when the adapter passed it on to its own children
+    fds[3].fd = m_process->GetExitFd();
+    fds[3].events = POLLIN;
+    int rc = Socket::Poll(fds, 4, msTimeout);
+    if (rc < 0) {
+        LOG_ERROR() << "dap(stdout): poll error:" << Socket::error() << endl;
+        return false;
+    } else if (rc == 0) {
+        return true;
+    }
+
+    if (fds[2].revents) {
+        m_interrupter->Clear();
+    }
+
+    if (fds[1].revents) {
+        char errbuf[4096];
+        while (true) {
+            ssize_t len = ::read(fds[1].fd, errbuf, sizeof(errbuf));
+            if (len > 0) {
+                LOG_INFO() << "dap(stderr)-->" << std::string_view(errbuf, len) << endl;
+                continue;
+            }
+            if (len == 0 || (errno != EINTR && errno != EAGAIN && errno != EWOULDBLOCK)) {
+                // stderr closed, keep reading stdout
+                m_stderrOpen = false;
+            }
+            if (len < 0 && errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+    }
+
+    size_t total = 0;
+    if (fds[0].revents) {
+        // read straight into the caller buffer until the pipe is drained
+        while (true) {
+            char* dest = buffer.PrepareWrite(64 << 10);
+            size_t room = buffer.WritableBytes();
+            ssize_t len = ::read(fds[0].fd, dest, room);
+            if (len > 0) {
+                buffer.Commit(static_cast<size_t>(len));
+                total += static_cast<size_t>(len);
+                if (static_cast<size_t>(len) < room) {
+                    break;
+                }
+                continue;
+            }
+            if (len < 0 && errno == EINTR) {
+                continue;
+            }
+            if (len < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                break;
+            }
+            // EOF or error: the process is gone. Report what we have first, the next call fails
+            if (total == 0) {
+                LOG_INFO() << "dap(stdout): pipe closed" << endl;
+                return false;
+            }
+            break;
+        }
+    }
+
+    if (fds[3].revents && total == 0 && !m_process->IsAlive()) {
+        // everything the process wrote before exiting has been read
+        LOG_INFO() << "dap(stdout): process exited with code" << m_process->GetExitCode() << endl;
+        return false;
+    }
+    return true;
+#endif
+}
+
 size_t dap::StdoutTransport::Send(const std::string& buffer)
+{
+    std::string_view view{ buffer };
+    return SendBatch(&view, 1);
+}
+
+size_t dap::StdoutTransport::SendBatch(const std::string_view* buffers, size_t count)
 {
     if (!IsAlive()) {
         return 0;
     }
 
-    // we need to append LF for the buffer to flush
-    if (!m_process->Write(buffer)) {
+    if (!m_process->WriteBatch(buffers, count)) {
         return 0;
     }
 
-    return buffer.length();
+    size_t total = 0;
+    for (size_t i = 0; i < count; ++i) {
+        total += buffers[i].size();
+    }
+    return total;
 }
 
 ///----------------------------------------------
@@ -143,6 +520,7 @@ dap::Client::Client()
     dap::Initialize();
     m_shutdown.store(false);
     m_terminated.store(false);
+    m_wakeupPending.store(false);
 }
 
 dap::Client::~Client() { Reset(); }
@@ -163,6 +541,8 @@ void dap::Client::StopReaderThread()
         return;
     }
     m_shutdown.store(true);
+    // wake up the reader if it is blocked waiting for data
+    m_transport->Interrupt();
     m_readerThread->join();
     wxDELETE(m_readerThread);
 }
@@ -174,13 +554,20 @@ void dap::Client::StartReaderThread()
     }
 
     m_readerThread = new thread(
-        [this](dap::Client* sink) {
+        [this](dap::Client* sink, bool parse) {
             LOG_INFO() << "Reader thread successfully started" << endl;
+            // when parsing on this thread, the framing state is owned by the thread
+            std::unique_ptr<JsonRPC> rpc(parse ? new JsonRPC() : nullptr);
+            // block until data arrives if StopReaderThread() can wake us up, otherwise poll the shutdown flag
+            int timeout = m_transport->IsInterruptible() ? -1 : 5;
+            ByteBuffer content;
             while (!m_shutdown.load()) {
-                std::string content;
-                bool success = m_transport->Read(content, 5);
-                if (success && !content.empty()) {
-                    sink->CallAfter(&dap::Client::OnDataRead, content);
+                bool success = m_transport->Read(content, timeout);
+                if (success && !content.IsEmpty()) {
+                    // wake up the main thread only if it is not already scheduled to drain the queues
+                    if (QueueIncoming(content, rpc.get()) && !m_wakeupPending.exchange(true)) {
+                        sink->CallAfter(&dap::Client::OnDataAvailable);
+                    }
                 } else if (!success) {
                     m_terminated.store(true);
                     sink->CallAfter(&dap::Client::OnConnectionError);
@@ -188,7 +575,28 @@ void dap::Client::StartReaderThread()
                 }
             }
         },
-        this);
+        this, m_parseOnReaderThread);
+}
+
+bool dap::Client::QueueIncoming(ByteBuffer& content, JsonRPC* rpc)
+{
+    if (!rpc) {
+        // hand the storage over to the main thread, the next read allocates a new buffer
+        m_incoming.push(std::move(content));
+        content.Clear();
+        return true;
+    }
+
+    bool queued = false;
+    // usually swaps the storage with the (drained) framing buffer: no copy, and `content` gets a buffer to reuse
+    rpc->AppendBuffer(content);
+    rpc->ProcessBuffer(
+        [this, &queued](const Json& json, wxObject*) {
+            m_incomingMessages.push({ json, ObjGenerator::Get().FromJSON(json) });
+            queued = true;
+        },
+        nullptr);
+    return queued;
 }
 
 void dap::Client::OnConnectionError()
@@ -212,20 +620,162 @@ void dap::Client::OnDataRead(const std::string& buffer)
     m_rpc.ProcessBuffer(dap::Client::StaticOnDataRead, this);
 }
 
+void dap::Client::OnDataAvailable()
+{
+    // clear the flag before draining: anything pushed after this point schedules a new call
+    m_wakeupPending.store(false);
+
+    ByteBuffer chunk;
+    bool has_data = false;
+    while (m_incoming.pop(chunk)) {
+        LOG_DEBUG() << "Processing buffer:" << chunk.View() << endl;
+        m_rpc.AppendBuffer(chunk);
+        has_data = true;
+    }
+
+    if (has_data) {
+        m_rpc.ProcessBuffer(dap::Client::StaticOnDataRead, this);
+    }
+
+    IncomingMessage incoming;
+    while (m_incomingMessages.pop(incoming)) {
+        OnMessage(std::move(incoming.json), std::move(incoming.message));
+    }
+}
+
+void dap::Client::SendProtocolMessage(ProtocolMessage& msg)
+{
+    if (m_corkDepth == 0) {
+        m_rpc.Send(msg, m_transport);
+        return;
+    }
+    if (!m_transport) {
+        throw Exception("Invalid connection");
+    }
+    m_corked.emplace_back(m_rpc.Serialize(msg));
+}
+
+void dap::Client::Uncork()
+{
+    if (--m_corkDepth > 0 || m_corked.empty()) {
+        return;
+    }
+
+    std::vector<std::string> frames;
+    frames.swap(m_corked);
+    if (!m_transport) {
+        return;
+    }
+    std::vector<std::string_view> views;
+    views.reserve(frames.size());
+    size_t total = 0;
+    for (const auto& frame : frames) {
+        views.emplace_back(frame);
+        total += frame.size();
+    }
+    try {
+        if (m_transport->SendBatch(views.data(), views.size()) < total) {
+            throw Exception("Send failed");
+        }
+    } catch (Exception& e) {
+        // the requests already have their pending entries: the reset fails them
+        OnConnectionError();
+    }
+}
+
 void dap::Client::StaticOnDataRead(Json json, wxObject* o)
 {
     dap::Client* This = static_cast<dap::Client*>(o);
     This->OnMessage(json);
 }
 
-dap::Request* dap::Client::GetOriginatingRequest(dap::Response* response)
+dap::Client::PendingRequest dap::Client::TakePendingRequest(int seq)
+{
+    auto iter = m_pending_requests.find(seq);
+    if (iter == m_pending_requests.end()) {
+        return {};
+    }
+    PendingRequest pending = std::move(iter->second);
+    m_pending_requests.erase(iter);
+    if (!pending.key.empty()) {
+        auto in_flight = m_in_flight_by_key.find(pending.key);
+        if (in_flight != m_in_flight_by_key.end() && in_flight->second == seq) {
+            m_in_flight_by_key.erase(in_flight);
+        }
+    }
+    return pending;
+}
+
+bool dap::Client::AttachToInFlight(dap::Request* request, PendingRequest& pending)
+{
+    auto iter = m_in_flight_by_key.find(pending.key);
+    if (iter == m_in_flight_by_key.end()) {
+        return false;
+    }
+    auto leader = m_pending_requests.find(iter->second);
+    if (leader == m_pending_requests.end() || leader->second.generation != pending.generation) {
+        // sent before the debuggee resumed or stopped, its response may not be the one we are asking for
+        return false;
+    }
+    pending.request.reset(request);
+    leader->second.followers.push_back(std::move(pending));
+    return true;
+}
+
+namespace
+{
+/// return `message` if it was already deserialized into a T by the reader thread, otherwise construct a message of
+/// type T and deserialize it from `json`
+template <typename T>
+std::shared_ptr<T> MakeMessage(const dap::Json& json, const dap::ProtocolMessage::Ptr_t& message)
 {
-    if (!response || (m_in_flight_requests.count(response->request_seq) == 0)) {
-        return nullptr;
+    auto msg = std::dynamic_pointer_cast<T>(message);
+    if (msg) {
+        return msg;
     }
-    auto req = m_in_flight_requests.find(response->request_seq)->second;
-    m_in_flight_requests.erase(response->request_seq);
-    return req;
+    msg = std::make_shared<T>();
+    msg->From(json);
+    return msg;
+}
+
+std::string StackTraceKey(const dap::StackTraceArguments& args)
+{
+    return "stackTrace/" + std::to_string(args.threadId) + "/" + std::to_string(args.startFrame) + "/" +
+           std::to_string(args.levels);
+}
+
+std::string ScopesKey(const dap::ScopesArguments& args) { return "scopes/" + std::to_string(args.frameId); }
+
+/// the context is not sent to the server, it is part of the key because the response carries it
+std::string VariablesKey(const dap::VariablesArguments& args, dap::EvaluateContext context)
+{
+    return "variables/" + std::to_string(args.variablesReference) + "/" + std::to_string(args.count) + "/" +
+           (args.format.hex ? "hex" : "native") + "/" + std::to_string(static_cast<int>(context));
+}
+
+std::string EvaluateKey(const dap::EvaluateArguments& args)
+{
+    return "evaluate/" + std::to_string(args.frameId) + "/" + args.context.mb_str(wxConvUTF8).data() + "/" +
+           (args.format.hex ? "hex" : "native") + "/" + args.expression.mb_str(wxConvUTF8).data();
+}
+} // namespace
+
+template <typename ResponseType>
+dap::Future<ResponseType> dap::Client::SendRequestAsync(dap::Request* request, PendingRequest pending)
+{
+    // if the request is never answered, the promise goes away with the pending entry and completes the future
+    auto promise = std::make_shared<Promise<ResponseType>>();
+    Future<ResponseType> future = promise->GetFuture();
+    auto on_response = std::move(pending.on_response);
+    pending.on_response = [promise, on_response](const Json& json, ProtocolMessage::Ptr_t message) {
+        auto response = MakeMessage<ResponseType>(json, message);
+        if (on_response) {
+            on_response(json, response);
+        }
+        promise->SetValue(response);
+    };
+    SendRequest(request, std::move(pending));
+    return future;
 }
 
 #define ENABLE_FEATURE(FeatureName)          \
@@ -233,7 +783,7 @@ dap::Request* dap::Client::GetOriginatingRequest(dap::Response* response)
         m_features |= FeatureName;           \
     }
 
-void dap::Client::OnMessage(Json json)
+void dap::Client::OnMessage(Json json, ProtocolMessage::Ptr_t message)
 {
     if (m_wants_log_events) {
         DAPEvent log_event{ wxEVT_DAP_LOG_EVENT };
@@ -241,10 +791,12 @@ void dap::Client::OnMessage(Json json)
         ProcessEvent(log_event);
     }
 
+    // only peek at the routing fields here: the typed message is constructed (and deserialized) once, by the branch
+    // that handles it (unless the reader thread already did it). Messages we don't handle are never materialized on
+    // this thread
+    std::string_view type = json["type"].GetStringView();
     if (m_handshake_state != eHandshakeState::kCompleted) {
-        // construct a message from the Json
-        ProtocolMessage::Ptr_t msg = ObjGenerator::Get().FromJSON(json);
-        if (msg && msg->type == "response" && msg->As<Response>()->command == "initialize") {
+        if (type == "response" && json["command"].GetStringView() == "initialize") {
             m_handshake_state = eHandshakeState::kCompleted;
             // turn the feature bits
             auto body = json["body"];
@@ -270,164 +822,195 @@ void dap::Client::OnMessage(Json json)
             ENABLE_FEATURE(supportsProgressReporting);
             ENABLE_FEATURE(supportsRunInTerminalRequest);
             ENABLE_FEATURE(supportsBreakpointLocationsRequest);
-            SendDAPEvent(wxEVT_DAP_INITIALIZE_RESPONSE, new dap::InitializeResponse, json, nullptr);
+            message = MakeMessage<dap::InitializeResponse>(json, message);
+            SendDAPEvent(wxEVT_DAP_INITIALIZE_RESPONSE, message, nullptr);
+            PendingRequest pending = TakePendingRequest(json["request_seq"].GetInteger());
+            if (pending.on_response) {
+                pending.on_response(json, message);
+            }
         }
         return;
     }
 
     // Other messages, convert the DAP message into wxEvent and fire it here
-    auto msg = dap::ObjGenerator::Get().FromJSON(json);
-    if (!msg) {
-        // unsupported event type
-        return;
-    }
-
-    auto as_event = msg->AsEvent();
-    auto as_response = msg->AsResponse();
-    auto as_request = msg->AsRequest();
-    if (as_event) {
+    if (type == "event") {
         // received an event
-        if (as_event->event == "stopped") {
+        std::string_view event_name = json["event"].GetStringView();
+        eMessageName event = FindMessageName(event_name);
+        switch (event) {
+        case eMessageName::kStopped:
             m_can_interact = true;
-            SendDAPEvent(wxEVT_DAP_STOPPED_EVENT, new dap::StoppedEvent, json, nullptr);
-        } else if (as_event->event == "process") {
-            SendDAPEvent(wxEVT_DAP_PROCESS_EVENT, new dap::ProcessEvent, json, nullptr);
-        } else if (as_event->event == "exited") {
-            SendDAPEvent(wxEVT_DAP_EXITED_EVENT, new dap::ExitedEvent, json, nullptr);
-        } else if (as_event->event == "terminated") {
-            SendDAPEvent(wxEVT_DAP_TERMINATED_EVENT, new dap::TerminatedEvent, json, nullptr);
-        } else if (as_event->event == "initialized") {
-            SendDAPEvent(wxEVT_DAP_INITIALIZED_EVENT, new dap::InitializedEvent, json, nullptr);
-        } else if (as_event->event == "output") {
-            SendDAPEvent(wxEVT_DAP_OUTPUT_EVENT, new dap::OutputEvent, json, nullptr);
-        } else if (as_event->event == "breakpoint") {
-            SendDAPEvent(wxEVT_DAP_BREAKPOINT_EVENT, new dap::BreakpointEvent, json, nullptr);
-        } else if (as_event->event == "continued") {
+            InvalidateStopState();
+            SendDAPEvent(wxEVT_DAP_STOPPED_EVENT, MakeMessage<dap::StoppedEvent>(json, message), nullptr);
+            if (m_prefetchOnStop && m_active_thread_id != wxNOT_FOUND) {
+                PrefetchStopState(m_active_thread_id);
+            }
+            break;
+        case eMessageName::kProcess:
+            SendDAPEvent(wxEVT_DAP_PROCESS_EVENT, MakeMessage<dap::ProcessEvent>(json, message), nullptr);
+            break;
+        case eMessageName::kExited:
+            SendDAPEvent(wxEVT_DAP_EXITED_EVENT, MakeMessage<dap::ExitedEvent>(json, message), nullptr);
+            break;
+        case eMessageName::kTerminated:
+            SendDAPEvent(wxEVT_DAP_TERMINATED_EVENT, MakeMessage<dap::TerminatedEvent>(json, message), nullptr);
+            break;
+        case eMessageName::kInitialized:
+            SendDAPEvent(wxEVT_DAP_INITIALIZED_EVENT, MakeMessage<dap::InitializedEvent>(json, message), nullptr);
+            break;
+        case eMessageName::kOutput:
+            SendDAPEvent(wxEVT_DAP_OUTPUT_EVENT, MakeMessage<dap::OutputEvent>(json, message), nullptr);
+            break;
+        case eMessageName::kBreakpoint:
+            SendDAPEvent(wxEVT_DAP_BREAKPOINT_EVENT, MakeMessage<dap::BreakpointEvent>(json, message), nullptr);
+            break;
+        case eMessageName::kContinued:
             m_can_interact = false;
-            SendDAPEvent(wxEVT_DAP_CONTINUED_EVENT, new dap::ContinuedEvent, json, nullptr);
-        } else if (as_event->event == "module") {
-            SendDAPEvent(wxEVT_DAP_MODULE_EVENT, new dap::ModuleEvent, json, nullptr);
-        } else {
-            // TODO implement here the rest of the event
+            InvalidateStopState();
+            SendDAPEvent(wxEVT_DAP_CONTINUED_EVENT, MakeMessage<dap::ContinuedEvent>(json, message), nullptr);
+            break;
+        case eMessageName::kModule:
+            SendDAPEvent(wxEVT_DAP_MODULE_EVENT, MakeMessage<dap::ModuleEvent>(json, message), nullptr);
+            break;
+        default:
+            break;
+        }
+
+        // application registered handlers
+        if (event != eMessageName::kUnknown) {
+            const auto& handler = m_event_handlers[static_cast<size_t>(event)];
+            if (handler) {
+                handler(json);
+            }
+        } else if (!m_other_event_handlers.empty()) {
+            auto iter = m_other_event_handlers.find(std::string(event_name));
+            if (iter != m_other_event_handlers.end()) {
+                iter->second(json);
+            }
         }
-    } else if (as_response) {
-        if (as_response->command == "stackTrace") {
+    } else if (type == "response") {
+        PendingRequest pending = TakePendingRequest(json["request_seq"].GetInteger());
+        switch (FindMessageName(json["command"].GetStringView())) {
+        case eMessageName::kStackTrace: {
             // received a stack trace response
-            auto response = new dap::StackTraceResponse;
-            if (!m_get_frames_queue.empty()) {
-                response->refId = m_get_frames_queue.front();
-                m_get_frames_queue.erase(m_get_frames_queue.begin());
+            auto response = MakeMessage<dap::StackTraceResponse>(json, message);
+            message = response;
+            if (pending.request) {
+                response->refId = pending.refId;
             }
-            SendDAPEvent(wxEVT_DAP_STACKTRACE_RESPONSE, response, json, GetOriginatingRequest(as_response));
-
-        } else if (as_response->command == "scopes") {
-            auto response = new dap::ScopesResponse;
-            if (!m_get_scopes_queue.empty()) {
-                response->refId = m_get_scopes_queue.front();
-                m_get_scopes_queue.erase(m_get_scopes_queue.begin());
+            SendResponseEvent(wxEVT_DAP_STACKTRACE_RESPONSE, response, pending);
+        } break;
+        case eMessageName::kScopes: {
+            auto response = MakeMessage<dap::ScopesResponse>(json, message);
+            message = response;
+            if (pending.request) {
+                response->refId = pending.refId;
             }
-            SendDAPEvent(wxEVT_DAP_SCOPES_RESPONSE, response, json, GetOriginatingRequest(as_response));
-        } else if (as_response->command == "variables") {
-            auto response = new dap::VariablesResponse;
-            if (!m_get_variables_queue.empty()) {
-                response->refId = m_get_variables_queue.front().first;
-                response->context = m_get_variables_queue.front().second;
-                m_get_variables_queue.erase(m_get_variables_queue.begin());
+            SendResponseEvent(wxEVT_DAP_SCOPES_RESPONSE, response, pending);
+        } break;
+        case eMessageName::kVariables: {
+            auto response = MakeMessage<dap::VariablesResponse>(json, message);
+            message = response;
+            if (pending.request) {
+                response->refId = pending.refId;
+                response->context = pending.context;
             }
 
-            SendDAPEvent(wxEVT_DAP_VARIABLES_RESPONSE, response, json, GetOriginatingRequest(as_response));
-
-        } else if (as_response->command == "stepIn" || as_response->command == "stepOut" ||
-                   as_response->command == "next" || as_response->command == "continue") {
+            SendResponseEvent(wxEVT_DAP_VARIABLES_RESPONSE, response, pending);
+        } break;
+        case eMessageName::kStepIn:
+        case eMessageName::kStepOut:
+        case eMessageName::kNext:
+        case eMessageName::kContinue:
             // the above responses indicate that the debugger accepted the corresponding command and can not be
             // interacted for now
             m_can_interact = false;
-
-        } else if (as_response->command == "breakpointLocations") {
+            InvalidateStopState();
+            break;
+        case eMessageName::kBreakpointLocations: {
             // special handling for breakpoint locations response:
             // we would also like to pass the origin source file that was passed as part of the
             // request
-            auto ptr = new dap::BreakpointLocationsResponse;
-            if (m_requestIdToFilepath.count(as_response->request_seq)) {
-                ptr->filepath = m_requestIdToFilepath[as_response->request_seq];
-                m_requestIdToFilepath.erase(as_response->request_seq);
+            auto ptr = MakeMessage<dap::BreakpointLocationsResponse>(json, message);
+            message = ptr;
+            if (pending.request) {
+                ptr->filepath = pending.filepath;
             }
-            SendDAPEvent(wxEVT_DAP_BREAKPOINT_LOCATIONS_RESPONSE, ptr, json, GetOriginatingRequest(as_response));
-
-        } else if (as_response->command == "setFunctionBreakpoints") {
-            SendDAPEvent(wxEVT_DAP_SET_FUNCTION_BREAKPOINT_RESPONSE, new dap::SetFunctionBreakpointsResponse, json,
-                         GetOriginatingRequest(as_response));
+            SendResponseEvent(wxEVT_DAP_BREAKPOINT_LOCATIONS_RESPONSE, ptr, pending);
+        } break;
+        case eMessageName::kSetFunctionBreakpoints: {
+            auto ptr = MakeMessage<dap::SetFunctionBreakpointsResponse>(json, message);
+            message = ptr;
+            SendResponseEvent(wxEVT_DAP_SET_FUNCTION_BREAKPOINT_RESPONSE, ptr, pending);
+        } break;
+        case eMessageName::kSetBreakpoints: {
+            auto ptr = MakeMessage<dap::SetBreakpointsResponse>(json, message);
+            message = ptr;
+            if (pending.request) {
+                ptr->originSource = pending.filepath;
+            }
+            SendResponseEvent(wxEVT_DAP_SET_SOURCE_BREAKPOINT_RESPONSE, ptr, pending);
+        } break;
+        case eMessageName::kConfigurationDone: {
+            auto ptr = MakeMessage<dap::ConfigurationDoneResponse>(json, message);
+            message = ptr;
+            SendResponseEvent(wxEVT_DAP_CONFIGURARIONE_DONE_RESPONSE, ptr, pending);
+        } break;
+        case eMessageName::kLaunch: {
+            auto ptr = MakeMessage<dap::LaunchResponse>(json, message);
+            message = ptr;
+            SendResponseEvent(wxEVT_DAP_LAUNCH_RESPONSE, ptr, pending);
+        } break;
+        case eMessageName::kThreads: {
+            auto ptr = MakeMessage<dap::ThreadsResponse>(json, message);
+            message = ptr;
+            SendResponseEvent(wxEVT_DAP_THREADS_RESPONSE, ptr, pending);
+        } break;
+        default:
+            break;
+        }
 
-        } else if (as_response->command == "setBreakpoints") {
-            auto ptr = new dap::SetBreakpointsResponse;
-            if (!m_source_breakpoints_queue.empty()) {
-                ptr->originSource = m_source_breakpoints_queue.front();
-                m_source_breakpoints_queue.erase(m_source_breakpoints_queue.begin());
+        // complete the future with the message the event carried
+        if (pending.on_response) {
+            pending.on_response(json, message);
+        }
+        // the requests that were coalesced with this one get the same response
+        for (auto& follower : pending.followers) {
+            if (follower.on_response) {
+                follower.on_response(json, message);
             }
-            SendDAPEvent(wxEVT_DAP_SET_SOURCE_BREAKPOINT_RESPONSE, ptr, json, GetOriginatingRequest(as_response));
-
-        } else if (as_response->command == "configurationDone") {
-            SendDAPEvent(wxEVT_DAP_CONFIGURARIONE_DONE_RESPONSE, new dap::ConfigurationDoneResponse, json,
-                         GetOriginatingRequest(as_response));
-        } else if (as_response->command == "launch") {
-            SendDAPEvent(wxEVT_DAP_LAUNCH_RESPONSE, new dap::LaunchResponse, json, GetOriginatingRequest(as_response));
-        } else if (as_response->command == "threads") {
-            SendDAPEvent(wxEVT_DAP_THREADS_RESPONSE, new dap::ThreadsResponse, json,
-                         GetOriginatingRequest(as_response));
-        } else if (as_response->command == "source") {
-            HandleSourceResponse(json);
-        } else if (as_response->command == "evaluate") {
-            HandleEvaluateResponse(json);
-        }
-    } else if (as_request) {
+        }
+    } else if (type == "request") {
         // reverse requests: request arriving from the dap server to the IDE
-        if (as_request->command == "runInTerminal") {
-            SendDAPEvent(wxEVT_DAP_RUN_IN_TERMINAL_REQUEST, new dap::RunInTerminalRequest, json, nullptr);
+        if (FindMessageName(json["command"].GetStringView()) == eMessageName::kRunInTerminal) {
+            SendDAPEvent(wxEVT_DAP_RUN_IN_TERMINAL_REQUEST, MakeMessage<dap::RunInTerminalRequest>(json, message), nullptr);
         }
     }
 }
 
-void dap::Client::HandleEvaluateResponse(Json json)
-{
-    if (m_evaluate_queue.empty()) {
-        // something bad happened..
-        return;
-    }
-
-    EvaluateResponse response;
-    response.From(json);
-
-    auto callback = std::move(m_evaluate_queue.front());
-    m_evaluate_queue.erase(m_evaluate_queue.begin());
-    callback(response.success, response.result, response.type, response.variablesReference);
-}
-
-void dap::Client::HandleSourceResponse(Json json)
+void dap::Client::RegisterEventHandler(const wxString& event, event_cb callback)
 {
-    if (m_load_sources_queue.empty()) {
-        // something bad happened..
-        return;
+    auto cb = event.mb_str(wxConvUTF8);
+    std::string name(cb.data(), cb.length());
+    eMessageName id = FindMessageName(name);
+    if (id != eMessageName::kUnknown) {
+        m_event_handlers[static_cast<size_t>(id)] = std::move(callback);
+    } else if (callback) {
+        m_other_event_handlers[name] = std::move(callback);
+    } else {
+        m_other_event_handlers.erase(name);
     }
-
-    SourceResponse response;
-    response.From(json);
-
-    auto callback = std::move(m_load_sources_queue.front());
-    m_load_sources_queue.erase(m_load_sources_queue.begin());
-    callback(response.success, response.content, response.mimeType);
 }
 
-void dap::Client::SendDAPEvent(wxEventType type, ProtocolMessage* dap_message, Json json, Request* req)
+void dap::Client::SendDAPEvent(wxEventType type, ProtocolMessage::Ptr_t dap_message, Request* req)
 {
-    std::shared_ptr<dap::Any> ptr{ dap_message };
-    ptr->From(json);
     if (type == wxEVT_DAP_STOPPED_EVENT) {
         // keep track of the current active thread ID
-        m_active_thread_id = ptr->As<StoppedEvent>()->threadId;
+        m_active_thread_id = dap_message->As<StoppedEvent>()->threadId;
     }
 
     DAPEvent event(type);
-    event.SetAnyObject(ptr);
+    event.SetAnyObject(dap_message);
     event.SetEventObject(this);
     if (req) {
         std::shared_ptr<dap::Request> request{ req };
@@ -436,33 +1019,158 @@ void dap::Client::SendDAPEvent(wxEventType type, ProtocolMessage* dap_message, J
     ProcessEvent(event);
 }
 
+void dap::Client::PrefetchStopState(int threadId)
+{
+    // a frame ID is only known from the stack trace and a variables reference from the scopes, so each step is sent
+    // from the completion of the previous one, without going through the application
+    size_t generation = m_stopGeneration;
+    auto snapshot = std::make_shared<StopSnapshot>();
+    snapshot->threadId = threadId;
+
+    auto req = MakeRequest<StackTraceRequest>();
+    req->arguments.threadId = threadId;
+    PendingRequest pending;
+    pending.refId = threadId;
+    pending.quiet = true;
+    pending.key = StackTraceKey(req->arguments);
+    pending.cacheable = true;
+    SendRequestAsync<StackTraceResponse>(req, std::move(pending))
+        .Then([this, snapshot, generation](const std::shared_ptr<StackTraceResponse>& frames) {
+            snapshot->stackTrace = frames;
+            // each step stops the chain once the debuggee resumed (or the client was reset): the requests would be
+            // answered for a state that is gone, or not at all
+            if (generation != m_stopGeneration || !frames || !frames->success || frames->stackFrames.empty()) {
+                return Future<ScopesResponse>{};
+            }
+            auto req = MakeRequest<ScopesRequest>();
+            req->arguments.frameId = frames->stackFrames[0].id;
+            PendingRequest pending;
+            pending.refId = req->arguments.frameId;
+            pending.quiet = true;
+            pending.key = ScopesKey(req->arguments);
+            pending.cacheable = true;
+            return SendRequestAsync<ScopesResponse>(req, std::move(pending));
+        })
+        .Then([this, snapshot, generation](const std::shared_ptr<ScopesResponse>& scopes) {
+            snapshot->scopes = scopes;
+            std::vector<Future<VariablesResponse>> fetches;
+            if (generation == m_stopGeneration && scopes && scopes->success) {
+                // one variables request per scope, sent with a single write
+                Cork();
+                fetches.reserve(scopes->scopes.size());
+                for (const auto& scope : scopes->scopes) {
+                    if (scope.expensive) {
+                        fetches.emplace_back();
+                        continue;
+                    }
+                    auto req = MakeRequest<VariablesRequest>();
+                    req->arguments.variablesReference = scope.variablesReference;
+                    PendingRequest pending;
+                    pending.refId = scope.variablesReference;
+                    pending.quiet = true;
+                    pending.key = VariablesKey(req->arguments, pending.context);
+                    pending.cacheable = true;
+                    fetches.push_back(SendRequestAsync<VariablesResponse>(req, std::move(pending)));
+                }
+                Uncork();
+            }
+            return WhenAll(fetches);
+        })
+        .Then([this, snapshot,
+               generation](const std::shared_ptr<std::vector<std::shared_ptr<VariablesResponse>>>& all) {
+            if (generation != m_stopGeneration) {
+                return;
+            }
+            snapshot->variables = *all;
+            DAPEvent event(wxEVT_DAP_STOP_SNAPSHOT);
+            event.SetAnyObject(snapshot);
+            event.SetEventObject(this);
+            ProcessEvent(event);
+        });
+}
+
+void dap::Client::SendResponseEvent(wxEventType type, ProtocolMessage::Ptr_t response, PendingRequest& pending)
+{
+    // a response sent before the debuggee resumed or stopped again describes a state that is gone
+    if (m_cacheResponses && pending.cacheable && pending.generation == m_stopGeneration &&
+        response->As<Response>()->success) {
+        m_responseCache[pending.key] = { type, response };
+    }
+    if (!pending.quiet) {
+        SendDAPEvent(type, response, pending.request.release());
+    }
+    for (auto& follower : pending.followers) {
+        if (!follower.quiet) {
+            SendDAPEvent(type, response, follower.request.release());
+        }
+    }
+}
+
+bool dap::Client::ReplyFromCache(dap::Request* request, PendingRequest& pending)
+{
+    auto iter = m_responseCache.find(pending.key);
+    if (iter == m_responseCache.end()) {
+        ++m_responseCacheStats.misses;
+        return false;
+    }
+    ++m_responseCacheStats.hits;
+
+    // the handlers may invalidate the cache, don't reference the entry
+    CachedResponse cached = iter->second;
+    pending.request.reset(request);
+    pending.cacheable = false;
+    SendResponseEvent(cached.type, cached.response, pending);
+    if (pending.on_response) {
+        pending.on_response(Json{}, cached.response);
+    }
+    return true;
+}
+
+void dap::Client::InvalidateStopState()
+{
+    ++m_stopGeneration;
+    m_responseCache.clear();
+}
+
 void dap::Client::Reset()
 {
+    if (m_resetting) {
+        // re-entered from a continuation of a dropped request
+        return;
+    }
+    m_resetting = true;
     StopReaderThread();
     wxDELETE(m_transport);
     m_shutdown.store(false);
     m_terminated.store(false);
+    // the reader thread is gone, discard whatever it read and did not get processed
+    ByteBuffer chunk;
+    while (m_incoming.pop(chunk)) {
+    }
+    IncomingMessage incoming;
+    while (m_incomingMessages.pop(incoming)) {
+    }
     m_rpc = {};
+    // held for the connection that is gone
+    m_corked.clear();
     m_requestSeuqnce = 0;
     m_handshake_state = eHandshakeState::kNotPerformed;
     m_active_thread_id = wxNOT_FOUND;
     m_can_interact = false;
-    m_requestIdToFilepath.clear();
     m_features = 0;
-    m_load_sources_queue.clear();
-    m_get_frames_queue.clear();
-    m_get_scopes_queue.clear();
-    m_get_variables_queue.clear();
-    m_source_breakpoints_queue.clear();
-    m_evaluate_queue.clear();
-    for (auto& vt : m_in_flight_requests) {
-        wxDELETE(vt.second);
-    }
-    m_in_flight_requests.clear();
+    InvalidateStopState();
+    m_responseCacheStats = {};
+    // dropping the unanswered requests completes their futures, whose continuations may send new requests. Do it
+    // last, once the client is reset: the requests they send fail right away (see SendRequest())
+    auto unanswered = std::move(m_pending_requests);
+    m_pending_requests.clear();
+    m_in_flight_by_key.clear();
+    unanswered.clear();
+    m_resetting = false;
 }
 
 /// API
-void dap::Client::Initialize(const dap::InitializeRequestArguments* initArgs)
+dap::Future<dap::InitializeResponse> dap::Client::Initialize(const dap::InitializeRequestArguments* initArgs)
 {
     // Send initialize request
     auto req = MakeRequest<InitializeRequest>();
@@ -474,11 +1182,13 @@ void dap::Client::Initialize(const dap::InitializeRequestArguments* initArgs)
         req->arguments.clientID = "wxdap";
         req->arguments.clientName = "wxdap";
     }
-    SendRequest(req);
+    auto future = SendRequestAsync<InitializeResponse>(req);
     m_handshake_state = eHandshakeState::kInProgress;
+    return future;
 }
 
-void dap::Client::SetBreakpointsFile(const wxString& file, const std::vector<dap::SourceBreakpoint>& lines)
+dap::Future<dap::SetBreakpointsResponse>
+dap::Client::SetBreakpointsFile(const wxString& file, const std::vector<dap::SourceBreakpoint>& lines)
 {
     // Now that the initialize is done, we can call 'setBreakpoints' command
     auto req = MakeRequest<SetBreakpointsRequest>();
@@ -487,17 +1197,19 @@ void dap::Client::SetBreakpointsFile(const wxString& file, const std::vector<dap
     req->arguments.source.name = wxFileName(file).GetFullName();
 
     // keep the originating source file
-    m_source_breakpoints_queue.push_back(file);
-    SendRequest(req);
+    PendingRequest pending;
+    pending.filepath = file;
+    return SendRequestAsync<SetBreakpointsResponse>(req, std::move(pending));
 }
 
-void dap::Client::ConfigurationDone()
+dap::Future<dap::ConfigurationDoneResponse> dap::Client::ConfigurationDone()
 {
     auto req = MakeRequest<ConfigurationDoneRequest>();
-    SendRequest(req);
+    return SendRequestAsync<ConfigurationDoneResponse>(req);
 }
 
-void dap::Client::Launch(std::vector<wxString>&& cmd, const wxString& workingDirectory, const dap::Environment& env)
+dap::Future<dap::LaunchResponse> dap::Client::Launch(std::vector<wxString>&& cmd, const wxString& workingDirectory,
+                                                     const dap::Environment& env)
 {
     m_active_thread_id = wxNOT_FOUND;
     auto req = MakeRequest<LaunchRequest>();
@@ -510,35 +1222,41 @@ void dap::Client::Launch(std::vector<wxString>&& cmd, const wxString& workingDir
     req->arguments.cwd = workingDirectory;
     req->arguments.env = env;
 
-    SendRequest(req);
+    return SendRequestAsync<LaunchResponse>(req);
 }
 
-void dap::Client::GetThreads()
+dap::Future<dap::ThreadsResponse> dap::Client::GetThreads()
 {
     auto req = MakeRequest<ThreadsRequest>();
-    SendRequest(req);
+    return SendRequestAsync<ThreadsResponse>(req);
 }
 
-void dap::Client::GetScopes(int frameId)
+dap::Future<dap::ScopesResponse> dap::Client::GetScopes(int frameId)
 {
     auto req = MakeRequest<ScopesRequest>();
     req->arguments.frameId = frameId;
-    m_get_scopes_queue.push_back(frameId);
-    SendRequest(req);
+    PendingRequest pending;
+    pending.refId = frameId;
+    pending.key = ScopesKey(req->arguments);
+    pending.cacheable = true;
+    return SendRequestAsync<ScopesResponse>(req, std::move(pending));
 }
 
-void dap::Client::GetFrames(int threadId, int starting_frame, int frame_count)
+dap::Future<dap::StackTraceResponse> dap::Client::GetFrames(int threadId, int starting_frame, int frame_count)
 {
     auto req = MakeRequest<StackTraceRequest>();
     req->arguments.threadId = threadId == wxNOT_FOUND ? GetActiveThreadId() : threadId;
     req->arguments.levels = frame_count;
     req->arguments.startFrame = starting_frame;
 
-    m_get_frames_queue.push_back(req->arguments.threadId);
-    SendRequest(req);
+    PendingRequest pending;
+    pending.refId = req->arguments.threadId;
+    pending.key = StackTraceKey(req->arguments);
+    pending.cacheable = true;
+    return SendRequestAsync<StackTraceResponse>(req, std::move(pending));
 }
 
-void dap::Client::Next(int threadId, bool singleThread, SteppingGranularity granularity)
+dap::Future<dap::NextResponse> dap::Client::Next(int threadId, bool singleThread, SteppingGranularity granularity)
 {
     auto req = MakeRequest<NextRequest>();
     req->arguments.threadId = threadId == wxNOT_FOUND ? GetActiveThreadId() : threadId;
@@ -555,83 +1273,109 @@ void dap::Client::Next(int threadId, bool singleThread, SteppingGranularity gran
         req->arguments.granularity = "instruction";
         break;
     }
-    SendRequest(req);
+    return SendRequestAsync<NextResponse>(req);
 }
 
-void dap::Client::Continue(int threadId, bool all_threads)
+dap::Future<dap::ContinueResponse> dap::Client::Continue(int threadId, bool all_threads)
 {
     auto req = MakeRequest<ContinueRequest>();
     req->arguments.threadId = threadId == wxNOT_FOUND ? GetActiveThreadId() : threadId;
     req->arguments.singleThread = !all_threads || (req->arguments.threadId == wxNOT_FOUND);
-    SendRequest(req);
+    return SendRequestAsync<ContinueResponse>(req);
 }
 
-void dap::Client::SetFunctionBreakpoints(const std::vector<dap::FunctionBreakpoint>& breakpoints)
+dap::Future<dap::SetFunctionBreakpointsResponse>
+dap::Client::SetFunctionBreakpoints(const std::vector<dap::FunctionBreakpoint>& breakpoints)
 {
     // place breakpoint based on function name
     auto req = MakeRequest<SetFunctionBreakpointsRequest>();
     req->arguments.breakpoints = breakpoints;
-    SendRequest(req);
+    return SendRequestAsync<SetFunctionBreakpointsResponse>(req);
 }
 
-void dap::Client::StepIn(int threadId, bool singleThread)
+dap::Future<dap::StepInResponse> dap::Client::StepIn(int threadId, bool singleThread)
 {
     auto req = MakeRequest<StepInRequest>();
     req->arguments.threadId = threadId == wxNOT_FOUND ? GetActiveThreadId() : threadId;
     req->arguments.singleThread = singleThread;
-    SendRequest(req);
+    return SendRequestAsync<StepInResponse>(req);
 }
 
-void dap::Client::StepOut(int threadId, bool singleThread)
+dap::Future<dap::StepOutResponse> dap::Client::StepOut(int threadId, bool singleThread)
 {
     auto req = MakeRequest<StepOutRequest>();
     req->arguments.threadId = threadId == wxNOT_FOUND ? GetActiveThreadId() : threadId;
     req->arguments.singleThread = singleThread;
-    SendRequest(req);
+    return SendRequestAsync<StepOutResponse>(req);
 }
 
-void dap::Client::GetChildrenVariables(int variablesReference, EvaluateContext context, size_t count,
-                                       ValueDisplayFormat format)
+dap::Future<dap::VariablesResponse> dap::Client::GetChildrenVariables(int variablesReference, EvaluateContext context,
+                                                                     size_t count, ValueDisplayFormat format)
 {
     auto req = MakeRequest<VariablesRequest>();
     req->arguments.variablesReference = variablesReference;
     req->arguments.count = count;
     req->arguments.format.hex = (format == ValueDisplayFormat::HEX);
-    m_get_variables_queue.push_back({ variablesReference, context });
-    SendRequest(req);
+    PendingRequest pending;
+    pending.refId = variablesReference;
+    pending.context = context;
+    pending.key = VariablesKey(req->arguments, context);
+    pending.cacheable = true;
+    return SendRequestAsync<VariablesResponse>(req, std::move(pending));
 }
 
-void dap::Client::Pause(int threadId)
+dap::Future<dap::PauseResponse> dap::Client::Pause(int threadId)
 {
     auto req = MakeRequest<PauseRequest>();
     req->arguments.threadId = threadId == wxNOT_FOUND ? GetActiveThreadId() : threadId;
-    SendRequest(req);
+    return SendRequestAsync<PauseResponse>(req);
 }
 
-void dap::Client::BreakpointLocations(const wxString& filepath, int start_line, int end_line)
+dap::Future<dap::BreakpointLocationsResponse> dap::Client::BreakpointLocations(const wxString& filepath,
+                                                                               int start_line, int end_line)
 {
     if (!IsSupported(supportsBreakpointLocationsRequest)) {
-        return;
+        return {};
     }
 
     auto req = MakeRequest<BreakpointLocationsRequest>();
     req->arguments.source.path = filepath;
     req->arguments.line = start_line;
     req->arguments.endLine = end_line;
-    SendRequest(req);
-    m_requestIdToFilepath.insert({ req->seq, filepath });
+    PendingRequest pending;
+    pending.filepath = filepath;
+    return SendRequestAsync<BreakpointLocationsResponse>(req, std::move(pending));
 }
 
-bool dap::Client::SendRequest(dap::Request* request)
+bool dap::Client::SendRequest(dap::Request* request, PendingRequest pending)
 {
+    if (m_resetting) {
+        // sent by a continuation of a request dropped by Reset(): there is no connection to report lost. Dropping
+        // `pending` completes its future with a null response
+        delete request;
+        return false;
+    }
+    if (!pending.key.empty()) {
+        if (pending.cacheable && m_cacheResponses && ReplyFromCache(request, pending)) {
+            return true;
+        }
+        pending.generation = m_stopGeneration;
+        if (m_coalesceRequests && AttachToInFlight(request, pending)) {
+            return true;
+        }
+    }
+    pending.request.reset(request);
     try {
-        m_rpc.Send(static_cast<dap::ProtocolMessage&>(*request), m_transport);
+        SendProtocolMessage(*request);
         if (m_wants_log_events) {
             DAPEvent log_event{ wxEVT_DAP_LOG_EVENT };
             log_event.SetString("--> " + request->To().ToString(false));
             ProcessEvent(log_event);
         }
-        m_in_flight_requests.insert({ request->seq, request });
+        if (m_coalesceRequests && !pending.key.empty()) {
+            m_in_flight_by_key[pending.key] = request->seq;
+        }
+        m_pending_requests[request->seq] = std::move(pending);
 
     } catch (Exception& e) {
         // an error occurred
@@ -643,8 +1387,11 @@ bool dap::Client::SendRequest(dap::Request* request)
 
 bool dap::Client::SendResponse(dap::Response& response)
 {
+    if (m_resetting) {
+        return false;
+    }
     try {
-        m_rpc.Send(response, m_transport);
+        SendProtocolMessage(response);
         if (m_wants_log_events) {
             DAPEvent log_event{ wxEVT_DAP_LOG_EVENT };
             log_event.SetString("--> " + response.To().ToString(false));
@@ -660,24 +1407,32 @@ bool dap::Client::SendResponse(dap::Response& response)
 
 bool dap::Client::LoadSource(const dap::Source& source, source_loaded_cb callback)
 {
-    if (source.sourceReference > 0) {
-        // queue request
-        m_load_sources_queue.emplace_back(std::move(callback));
-        auto req = MakeRequest<SourceRequest>();
-        req->arguments.source = source;
-        req->arguments.sourceReference = source.sourceReference;
-        SendRequest(req);
-        return true;
-
-    } else {
+    if (source.sourceReference <= 0) {
         return false;
     }
+    LoadSource(source).Then([callback](const std::shared_ptr<SourceResponse>& response) {
+        if (response) {
+            callback(response->success, response->content, response->mimeType);
+        }
+    });
+    return true;
 }
 
-void dap::Client::EvaluateExpression(const wxString& expression, int frameId, EvaluateContext context,
-                                     evaluate_cb callback, ValueDisplayFormat format)
+dap::Future<dap::SourceResponse> dap::Client::LoadSource(const dap::Source& source)
+{
+    if (source.sourceReference <= 0) {
+        return {};
+    }
+    auto req = MakeRequest<SourceRequest>();
+    req->arguments.source = source;
+    req->arguments.sourceReference = source.sourceReference;
+    return SendRequestAsync<SourceResponse>(req);
+}
+
+dap::Future<dap::EvaluateResponse> dap::Client::EvaluateExpression(const wxString& expression, int frameId,
+                                                                   EvaluateContext context, evaluate_cb callback,
+                                                                   ValueDisplayFormat format)
 {
-    m_evaluate_queue.emplace_back(std::move(callback));
     auto req = MakeRequest<EvaluateRequest>();
     req->arguments.frameId = frameId;
     req->arguments.expression = expression;
@@ -699,12 +1454,25 @@ void dap::Client::EvaluateExpression(const wxString& expression, int frameId, Ev
         req->arguments.context = "watch";
         break;
     }
-    SendRequest(req);
+    PendingRequest pending;
+    if (context != EvaluateContext::REPL) {
+        // REPL input may have side effects, every one of them has to reach the debugger
+        pending.key = EvaluateKey(req->arguments);
+    }
+    auto future = SendRequestAsync<EvaluateResponse>(req, std::move(pending));
+    if (callback) {
+        future.Then([callback](const std::shared_ptr<EvaluateResponse>& response) {
+            if (response) {
+                callback(response->success, response->result, response->type, response->variablesReference);
+            }
+        });
+    }
+    return future;
 }
 
-void dap::Client::Attach(int pid, const std::vector<wxString>& arguments)
+dap::Future<dap::AttachResponse> dap::Client::Attach(int pid, const std::vector<wxString>& arguments)
 {
     auto req = MakeRequest<AttachRequest>();
     req->arguments.arguments = arguments;
-    SendRequest(req);
+    return SendRequestAsync<AttachResponse>(req);
 }
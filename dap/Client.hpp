@@ -1,13 +1,23 @@
 #pragma once
 
+#include "Future.hpp"
+#include "Interrupter.hpp"
 #include "JsonRPC.hpp"
 #include "Process.hpp"
 #include "Queue.hpp"
+#include "SPSCQueue.hpp"
 #include "Socket.hpp"
 #include "dap_exports.hpp"
 
+#include <array>
 #include <atomic>
+#include <deque>
 #include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 #include <wx/event.h>
 #include <wx/string.h>
@@ -27,34 +37,127 @@ public:
     /**
      * @brief return from the network with a given timeout
      * @returns true on success, false in case of an error. True is also returned when timeout occurs, check the buffer
-     * length if it is 0, timeout occurred
+     * length if it is 0, timeout occurred. Interruptible transports accept a negative timeout (wait until data
+     * arrives or `Interrupt()` is called)
      */
     virtual bool Read(std::string& WXUNUSED(buffer), int msTimeout) = 0;
 
+    /**
+     * @brief same as above, but append the data to `buffer`. Transports that can, override this to receive straight
+     * into the buffer, the default implementation copies the result of `Read(std::string&, int)`
+     */
+    virtual bool Read(ByteBuffer& buffer, int msTimeout);
+
+    /**
+     * @brief does this transport implement `Interrupt()`? If it does, the client reader thread blocks in `Read()`
+     * until data arrives instead of polling it with a short timeout
+     */
+    virtual bool IsInterruptible() const { return false; }
+
+    /**
+     * @brief wake up a `Read()` call blocked in another thread (or the next one, if none is in progress), which then
+     * returns true with an empty buffer
+     */
+    virtual void Interrupt() {}
+
     /**
      * @brief send data over the network
      * @return number of bytes written
      */
     virtual size_t Send(const std::string& WXUNUSED(buffer)) = 0;
+
+    /**
+     * @brief send `count` buffers back to back (e.g. several framed messages). Transports that can, override this to
+     * hand them to the OS in a single call, the default implementation calls `Send()` for each buffer
+     * @return number of bytes written
+     */
+    virtual size_t SendBatch(const std::string_view* buffers, size_t count);
 };
 
 /// simple socket implementation for Socket
+///
+/// `Send()` never blocks: whatever the socket does not accept immediately is queued and written by the thread calling
+/// `Read()` (the client reader thread) as soon as the socket becomes writable
 class WXDLLIMPEXP_DAP SocketTransport : public Transport
 {
+public:
+    /// called with the number of queued bytes when the send queue grows past the high-water mark
+    typedef std::function<void(size_t)> high_water_cb;
+
+protected:
     Socket* m_socket = nullptr;
+    std::unique_ptr<Interrupter> m_interrupter;
+
+    /// a queued buffer, and the descriptors (owned) to pass along with its first byte
+    struct Outgoing {
+        std::string data;
+        std::vector<int> fds;
+    };
+
+    /// outgoing data not yet accepted by the socket. The first m_sendOffset bytes of the front buffer were sent
+    std::mutex m_sendLock;
+    std::deque<Outgoing> m_sendQueue;
+    size_t m_sendOffset = 0;
+    std::atomic<size_t> m_pendingBytes{ 0 };
+    std::atomic_bool m_sendFailed{ false };
+    size_t m_highWaterMark = 0;
+    high_water_cb m_onHighWater;
+    bool m_aboveHighWater = false;
+
+    /// write as much of the send queue as the socket accepts. Must be called with m_sendLock held
+    /// @throws SocketException
+    void DoFlush();
+
+    /// flush the send queue, return false on error
+    bool Flush();
+
+    /// account for `bytes` just queued under `lock` and try to write them. Releases the lock
+    /// @return `bytes`, or 0 on error
+    size_t SendQueued(std::unique_lock<std::mutex>& lock, size_t bytes);
+
+    /// close the descriptors of a queued buffer
+    static void CloseDescriptors(Outgoing& outgoing);
 
 public:
     SocketTransport();
     virtual ~SocketTransport();
 
     bool Read(std::string& buffer, int msTimeout) override;
+    bool Read(ByteBuffer& buffer, int msTimeout) override;
     size_t Send(const std::string& buffer) override;
+    size_t SendBatch(const std::string_view* buffers, size_t count) override;
+    bool IsInterruptible() const override { return m_interrupter != nullptr; }
+    void Interrupt() override;
+
+#ifndef _WIN32
+    /**
+     * @brief like `Send()`, passing the descriptors `fds` (SCM_RIGHTS) along with the first byte of `buffer` (must not
+     * be empty). Unix domain sockets only. The descriptors are duplicated: the caller keeps ownership of `fds`
+     * @return number of bytes written or queued, 0 on error
+     */
+    size_t SendWithDescriptors(std::string_view buffer, const std::vector<int>& fds);
+#endif
 
     // socket specific
     bool Connect(const std::string& connection_string, int timeoutSeconds);
+
+    /**
+     * @brief number of bytes passed to `Send()` and not yet written to the socket
+     */
+    size_t GetPendingBytes() const { return m_pendingBytes.load(); }
+
+    /**
+     * @brief call `callback` (on the thread calling `Send()`) whenever the send queue grows past `bytes`. The callback
+     * is called once per crossing: it is re-armed when the queue drains below the mark. Pass 0 to disable
+     */
+    void SetHighWaterMark(size_t bytes, high_water_cb callback);
 };
 
 /// simple socket implementation for Socket
+///
+/// Where the platform allows it (POSIX), the child stdout / stderr pipes are polled directly by the thread calling
+/// `Read()` and stdout is read straight into the caller buffer. Otherwise the data goes through the Process reader
+/// threads and queues
 class WXDLLIMPEXP_DAP StdoutTransport : public Transport
 {
 public:
@@ -62,21 +165,35 @@ public:
     virtual ~StdoutTransport();
 
     bool Read(std::string& buffer, int msTimeout) override;
+    bool Read(ByteBuffer& buffer, int msTimeout) override;
     size_t Send(const std::string& buffer) override;
+    size_t SendBatch(const std::string_view* buffers, size_t count) override;
+    bool IsInterruptible() const override { return m_interrupter != nullptr; }
+    void Interrupt() override;
 
     /// Execute the DAP server and connect to it by redirecting stdin/out
     bool Execute(const std::vector<wxString>& command, const wxString& workingDirectory = {});
 
 protected:
     bool IsAlive() const;
+    /// read from the child pipes directly (m_interrupter is set only in this mode)
+    bool DoReadPipes(ByteBuffer& buffer, int msTimeout);
 
 private:
     Process* m_process = nullptr;
+    std::unique_ptr<Interrupter> m_interrupter;
+    bool m_stderrOpen = true;
 };
 
 typedef std::function<void(bool, const wxString&, const wxString&)> source_loaded_cb;
 typedef std::function<void(bool, const wxString&, const wxString&, int)> evaluate_cb;
+typedef std::function<void(const Json&)> event_cb;
 
+/// A DAP client. Responses and events are delivered as DAPEvent on the main thread.
+///
+/// The request methods also return a `Future` completed with the response (after its event has been processed), so
+/// dependent requests can be chained with `Future::Then()` and combined with `WhenAll()`. If the session is reset
+/// before the response arrives, the future completes with a null response
 class WXDLLIMPEXP_DAP Client : public wxEvtHandler
 {
     enum eFeatures {
@@ -108,14 +225,36 @@ protected:
     enum class eHandshakeState { kNotPerformed, kInProgress, kCompleted };
     Transport* m_transport = nullptr;
     dap::JsonRPC m_rpc;
+    /// while the client sends several requests of its own in a row (e.g. the variables of every scope after a stop),
+    /// they are held here and leave together in a single SendBatch() call (see Cork()). Never while application code
+    /// runs: its requests are always written right away
+    int m_corkDepth = 0;
+    std::vector<std::string> m_corked;
     std::atomic_bool m_shutdown;
     std::atomic_bool m_terminated;
     std::thread* m_readerThread = nullptr;
+    /// chunks read by the reader thread, waiting to be processed on the main thread
+    SPSCQueue<ByteBuffer> m_incoming;
+    /// a message framed, parsed and deserialized by the reader thread (see SetParseOnReaderThread())
+    struct IncomingMessage {
+        Json json;
+        ProtocolMessage::Ptr_t message;
+    };
+    /// messages parsed by the reader thread, waiting to be dispatched on the main thread
+    SPSCQueue<IncomingMessage> m_incomingMessages;
+    /// set while Reset() runs
+    bool m_resetting = false;
+    bool m_parseOnReaderThread = false;
+    bool m_prefetchOnStop = false;
+    /// incremented whenever the debuggee resumes or stops: a stop snapshot or a response to a cacheable request
+    /// completed in another generation is stale
+    size_t m_stopGeneration = 0;
+    /// set while an OnDataAvailable() call is queued on the main thread
+    std::atomic_bool m_wakeupPending;
     size_t m_requestSeuqnce = 0;
     eHandshakeState m_handshake_state = eHandshakeState::kNotPerformed;
     int m_active_thread_id = wxNOT_FOUND;
     bool m_can_interact = false;
-    std::unordered_map<size_t, wxString> m_requestIdToFilepath;
     size_t m_features = 0;
 
     /// set this to true if you wish to receive (in addition to the regular events)
@@ -123,26 +262,88 @@ protected:
     /// wxdap and the dap-server
     bool m_wants_log_events = false;
 
-    /// the ID of threads that called GetFrames()
-    std::vector<int> m_get_frames_queue;
-    std::vector<int> m_get_scopes_queue;
-    std::vector<std::pair<int, EvaluateContext>> m_get_variables_queue;
-    std::vector<source_loaded_cb> m_load_sources_queue;
-    std::vector<evaluate_cb> m_evaluate_queue;
-    std::vector<wxString> m_source_breakpoints_queue;
-    std::unordered_map<int, dap::Request*> m_in_flight_requests;
+    /// a request sent to the server and not answered yet, with what its response handler needs to know about it
+    struct PendingRequest {
+        /// passed to the response event as its originating request
+        std::unique_ptr<dap::Request> request;
+        /// stackTrace: the thread ID, scopes: the frame ID, variables: the variables reference
+        int refId = wxNOT_FOUND;
+        EvaluateContext context = EvaluateContext::VARIABLES;
+        /// setBreakpoints and breakpointLocations: the source file
+        wxString filepath;
+        /// called with the response, if set
+        std::function<void(const Json&, ProtocolMessage::Ptr_t)> on_response;
+        /// don't fire the response event, only call `on_response` (requests the client sends on its own)
+        bool quiet = false;
+        /// identifies the requests with the same arguments (stackTrace, scopes, variables and evaluate), which get
+        /// the same response
+        std::string key;
+        /// the response can be kept in the response cache (stackTrace, scopes and variables)
+        bool cacheable = false;
+        /// the value of m_stopGeneration when the request was sent
+        size_t generation = 0;
+        /// identical requests made while this one was in flight: they are answered with its response
+        std::vector<PendingRequest> followers;
+    };
+    /// pending requests indexed by their sequence: responses are matched by `request_seq`, in whatever order they
+    /// arrive
+    std::unordered_map<int, PendingRequest> m_pending_requests;
+    bool m_coalesceRequests = false;
+    /// the sequence of the pending request sent for each PendingRequest::key
+    std::unordered_map<std::string, int> m_in_flight_by_key;
+    /// application handlers registered with RegisterEventHandler(), indexed by the event name id
+    std::array<event_cb, static_cast<size_t>(eMessageName::kCount)> m_event_handlers;
+    std::unordered_map<std::string, event_cb> m_other_event_handlers;
+
+public:
+    struct ResponseCacheStats {
+        /// requests answered from the cache, without a round trip to the server
+        size_t hits = 0;
+        /// cacheable requests sent to the server
+        size_t misses = 0;
+    };
+
+protected:
+    /// a successful response and the type of the event it is delivered with
+    struct CachedResponse {
+        wxEventType type;
+        ProtocolMessage::Ptr_t response;
+    };
+    bool m_cacheResponses = false;
+    /// the stackTrace, scopes and variables responses received since the debuggee stopped, by PendingRequest::key
+    std::unordered_map<std::string, CachedResponse> m_responseCache;
+    ResponseCacheStats m_responseCacheStats;
 
 protected:
     bool IsSupported(eFeatures feature) const { return m_features & feature; }
-    bool SendRequest(dap::Request* request);
-    void HandleSourceResponse(Json json);
-    void HandleEvaluateResponse(Json json);
-    /// Return the originating request for `response`
-    /// Might return null
-    dap::Request* GetOriginatingRequest(dap::Response* response);
+    /// send `request` (the client takes its ownership) and keep `pending` until its response arrives
+    bool SendRequest(dap::Request* request, PendingRequest pending);
+    bool SendRequest(dap::Request* request) { return SendRequest(request, PendingRequest{}); }
+    /// same as SendRequest(), return a future completed with the response
+    template <typename ResponseType>
+    Future<ResponseType> SendRequestAsync(dap::Request* request, PendingRequest pending);
+    template <typename ResponseType>
+    Future<ResponseType> SendRequestAsync(dap::Request* request)
+    {
+        return SendRequestAsync<ResponseType>(request, PendingRequest{});
+    }
+    /// remove and return the pending entry of request `seq`. Empty if there is none
+    PendingRequest TakePendingRequest(int seq);
 
 protected:
-    void SendDAPEvent(wxEventType type, ProtocolMessage* dap_message, Json json, Request* req);
+    /// fire `dap_message` (already deserialized) as a DAPEvent of the given type
+    void SendDAPEvent(wxEventType type, ProtocolMessage::Ptr_t dap_message, Request* req);
+    /// fire the event of `response`, unless `pending` is quiet, and keep `response` in the cache if it can be reused
+    void SendResponseEvent(wxEventType type, ProtocolMessage::Ptr_t response, PendingRequest& pending);
+    /// answer `request` with the cached response to the same request, if there is one. Return false on cache miss
+    bool ReplyFromCache(dap::Request* request, PendingRequest& pending);
+    /// if an identical request is in flight, answer `request` with its response instead of sending it
+    bool AttachToInFlight(dap::Request* request, PendingRequest& pending);
+    /// the debuggee resumed or stopped: drop the cached responses and the stop snapshot being fetched
+    void InvalidateStopState();
+    /// fetch the stack trace of `threadId`, the scopes of its top frame and their variables, then fire a
+    /// wxEVT_DAP_STOP_SNAPSHOT event
+    void PrefetchStopState(int threadId);
 
     /**
      * @brief we maintain a reader thread that is responsible for reading
@@ -156,20 +357,46 @@ protected:
     void StopReaderThread();
 
     /**
-     * @brief this callback is called by the reader thread whenever data arrives on the socket
+     * @brief process data received from the DAP server
      */
     void OnDataRead(const std::string& buffer);
 
+    /**
+     * @brief called by the reader thread with the content of a read. Queue the content (or, if `rpc` is set, the
+     * messages it completes, parsed with `rpc`) for the main thread. Return true if anything was queued
+     */
+    bool QueueIncoming(ByteBuffer& content, JsonRPC* rpc);
+
+    /**
+     * @brief queued on the main thread by the reader thread when data arrives on an idle queue. Processes everything
+     * that has been read since the previous call in a single pass
+     */
+    void OnDataAvailable();
+
     /**
      * @brief lost connection to the DAP server
      */
     void OnConnectionError();
 
+    /**
+     * @brief send `msg` to the server, or hold it until the matching Uncork() call while corked
+     * @throws Exception
+     */
+    void SendProtocolMessage(ProtocolMessage& msg);
+
+    /**
+     * @brief hold the outgoing messages until Uncork(). Calls nest, the messages are sent by the outermost Uncork()
+     */
+    void Cork() { ++m_corkDepth; }
+    /// send the held messages, a transport error (or short write) is handled as a lost connection
+    void Uncork();
+
     /**
      * @brief handle Json payload received from the DAP server
      * @param json
+     * @param message the deserialized message, if it was already constructed by the reader thread
      */
-    void OnMessage(Json json);
+    void OnMessage(Json json, ProtocolMessage::Ptr_t message = nullptr);
     static void StaticOnDataRead(Json json, wxObject* o);
 
 public:
@@ -181,6 +408,50 @@ public:
      */
     void SetWantsLogEvents(bool b) { m_wants_log_events = b; }
 
+    /**
+     * @brief when enabled, the reader thread also frames and parses the incoming data and deserializes the messages.
+     * Only the ready to use messages are handed to the main thread, so large responses (e.g. `variables` or `source`)
+     * no longer block it. Takes effect on the next call to SetTransport()
+     */
+    void SetParseOnReaderThread(bool b) { m_parseOnReaderThread = b; }
+
+    /**
+     * @brief when enabled, the client fetches the state of the stopped thread as soon as a `stopped` event arrives:
+     * its stack trace, the scopes of the top frame and the variables of every non expensive scope. Each request is
+     * sent from the handler of the response it depends on, the variables requests are all sent at once, and the
+     * result is delivered as a single wxEVT_DAP_STOP_SNAPSHOT event (carrying a dap::StopSnapshot) instead of the
+     * individual response events. The snapshot is dropped if the debuggee resumes before it is complete
+     */
+    void SetPrefetchOnStop(bool b) { m_prefetchOnStop = b; }
+
+    /**
+     * @brief when enabled, the stackTrace, scopes and variables responses are kept until the debuggee resumes or
+     * stops again, and GetFrames(), GetScopes() and GetChildrenVariables() called with the same arguments are answered
+     * from the cache. A cached response is delivered right away: the response event fires (and the returned future
+     * completes) before the method returns
+     */
+    void SetCacheResponses(bool b)
+    {
+        m_cacheResponses = b;
+        if (!b) {
+            m_responseCache.clear();
+        }
+    }
+
+    /**
+     * @brief when enabled, a stackTrace, scopes, variables or evaluate (except in the REPL context) request identical
+     * to one that is still waiting for its response is not sent: both callers get that response, each with its own
+     * response event and future. Disabled by default, as it changes what goes over the wire: the request of a
+     * follower is never sent, so the response delivered with its event carries the `request_seq` of the request that
+     * was sent, not the `seq` of the follower's own request (GetOriginatingRequest() still returns the latter)
+     */
+    void SetCoalesceRequests(bool b) { m_coalesceRequests = b; }
+
+    /**
+     * @brief the response cache hit and miss counters since the last Reset()
+     */
+    const ResponseCacheStats& GetResponseCacheStats() const { return m_responseCacheStats; }
+
     template <typename RequestType>
     RequestType* MakeRequest()
     {
@@ -189,6 +460,14 @@ public:
         return req;
     }
 
+    /**
+     * @brief register a handler for the DAP event `event` (e.g. "capabilities", "progressStart").
+     * The handler receives the raw message and is called for every event with that name, including events that
+     * the client does not turn into a DAPEvent. Only one handler per event is kept, pass an empty callback to
+     * remove it
+     */
+    void RegisterEventHandler(const wxString& event, event_cb callback);
+
     /**
      * @brief send back a response to the dap server
      * should be used when receiving a reverse request from the dap server
@@ -224,7 +503,7 @@ public:
     /**
      * @brief initiate the handshake between the server and the client
      */
-    void Initialize(const dap::InitializeRequestArguments* initArgs = nullptr);
+    Future<InitializeResponse> Initialize(const dap::InitializeRequestArguments* initArgs = nullptr);
 
     /**
      * @brief are we still connected?
@@ -234,17 +513,19 @@ public:
     /**
      * @brief set multiple breakpoints in a source file
      */
-    void SetBreakpointsFile(const wxString& file, const std::vector<dap::SourceBreakpoint>& lines);
+    Future<SetBreakpointsResponse> SetBreakpointsFile(const wxString& file,
+                                                      const std::vector<dap::SourceBreakpoint>& lines);
 
     /**
      * @brief set breakpoint on a function
      */
-    void SetFunctionBreakpoints(const std::vector<dap::FunctionBreakpoint>& breakpoints);
+    Future<SetFunctionBreakpointsResponse>
+    SetFunctionBreakpoints(const std::vector<dap::FunctionBreakpoint>& breakpoints);
 
     /**
      * @brief tell the debugger that we are done and ready to start the main loop
      */
-    void ConfigurationDone();
+    Future<ConfigurationDoneResponse> ConfigurationDone();
 
     /**
      * @brief start the debuggee
@@ -252,17 +533,17 @@ public:
      * @param workingDirectory the debuggee working directory
      * @param env extra environment variable to pass to the debuggee
      */
-    void Launch(std::vector<wxString>&& cmd, const wxString& workingDirectory = wxEmptyString,
-                const dap::Environment& env = {});
+    Future<LaunchResponse> Launch(std::vector<wxString>&& cmd, const wxString& workingDirectory = wxEmptyString,
+                                  const dap::Environment& env = {});
     /**
      * @brief attach to dap server
      */
-    void Attach(int pid = wxNOT_FOUND, const std::vector<wxString>& arguments = {});
+    Future<AttachResponse> Attach(int pid = wxNOT_FOUND, const std::vector<wxString>& arguments = {});
 
     /**
      * @brief ask for list of threads
      */
-    void GetThreads();
+    Future<ThreadsResponse> GetThreads();
 
     /**
      * @brief get list of frames for a given thread ID
@@ -270,12 +551,12 @@ public:
      * @param starting_frame
      * @param frame_count number of frames to return
      */
-    void GetFrames(int threadId = wxNOT_FOUND, int starting_frame = 0, int frame_count = 0);
+    Future<StackTraceResponse> GetFrames(int threadId = wxNOT_FOUND, int starting_frame = 0, int frame_count = 0);
 
     /**
      * @brief continue execution
      */
-    void Continue(int threadId = wxNOT_FOUND, bool all_threads = true);
+    Future<ContinueResponse> Continue(int threadId = wxNOT_FOUND, bool all_threads = true);
 
     /**
      * @brief The request executes one step (in the given granularity) for the specified thread and allows all other
@@ -284,29 +565,31 @@ public:
      * GetActiveThreadId()
      * @param singleThread If this optional flag is true, execution is resumed only for the thread
      */
-    void Next(int threadId = wxNOT_FOUND, bool singleThread = true,
-              SteppingGranularity granularity = SteppingGranularity::LINE);
+    Future<NextResponse> Next(int threadId = wxNOT_FOUND, bool singleThread = true,
+                              SteppingGranularity granularity = SteppingGranularity::LINE);
 
     /**
      * @brief return the variable scopes for a given frame
      * @param frameId
      */
-    void GetScopes(int frameId);
+    Future<ScopesResponse> GetScopes(int frameId);
 
     /**
-     * @brief reset the session and clear all states
+     * @brief reset the session and clear all states. The futures of the unanswered requests complete with a null
+     * response once everything else is reset. Requests sent by their continuations fail right away: their futures
+     * complete with a null response too, and no wxEVT_DAP_LOST_CONNECTION is fired
      */
     void Reset();
 
     /**
      * @brief step into function
      */
-    void StepIn(int threadId = wxNOT_FOUND, bool singleThread = true);
+    Future<StepInResponse> StepIn(int threadId = wxNOT_FOUND, bool singleThread = true);
 
     /**
      * @brief step out of a function
      */
-    void StepOut(int threadId = wxNOT_FOUND, bool singleThread = true);
+    Future<StepOutResponse> StepOut(int threadId = wxNOT_FOUND, bool singleThread = true);
 
     /**
      * @brief return the list of all children variables for `variablesReference`
@@ -314,19 +597,22 @@ public:
      * @param context the context of variablesReference
      * @param count number of children. If count 0, all variables are returned
      */
-    void GetChildrenVariables(int variablesReference, EvaluateContext context = EvaluateContext::VARIABLES,
-                              size_t count = 10, ValueDisplayFormat format = ValueDisplayFormat::NATIVE);
+    Future<VariablesResponse> GetChildrenVariables(int variablesReference,
+                                                   EvaluateContext context = EvaluateContext::VARIABLES,
+                                                   size_t count = 10,
+                                                   ValueDisplayFormat format = ValueDisplayFormat::NATIVE);
 
     /**
      * @brief The request suspends the debuggee.
      * @param threadId
      */
-    void Pause(int threadId = wxNOT_FOUND);
+    Future<PauseResponse> Pause(int threadId = wxNOT_FOUND);
 
     /**
      * @brief request list of all breakpoints in a file
      */
-    void BreakpointLocations(const wxString& filepath, int start_line, int end_line);
+    Future<BreakpointLocationsResponse> BreakpointLocations(const wxString& filepath, int start_line,
+                                                            int end_line);
 
     /**
      * @brief request to load a source and execute callback once the source is loaded. If the `source` contains
@@ -336,6 +622,12 @@ public:
      */
     bool LoadSource(const dap::Source& source, source_loaded_cb callback);
 
+    /**
+     * @brief load a source by its sourceReference. Return a future completed with the response, or a null
+     * response if `source` has no sourceReference
+     */
+    Future<SourceResponse> LoadSource(const dap::Source& source);
+
     /**
      * @brief evaluate an expression. This method uses callback instead of event since a context is required
      * (e.g. the caller want to associate the evaluated expression with the expression)
@@ -348,8 +640,9 @@ public:
      *   children can be retrieved by passing variablesReference to the
      *   VariablesRequest
      */
-    void EvaluateExpression(const wxString& expression, int frameId, EvaluateContext context, evaluate_cb callback,
-                            ValueDisplayFormat format = ValueDisplayFormat::NATIVE);
+    Future<EvaluateResponse> EvaluateExpression(const wxString& expression, int frameId, EvaluateContext context,
+                                                evaluate_cb callback = {},
+                                                ValueDisplayFormat format = ValueDisplayFormat::NATIVE);
 };
 
 }; // namespace dap
@@ -15,6 +15,8 @@ wxDEFINE_EVENT(wxEVT_DAP_SET_FUNCTION_BREAKPOINT_RESPONSE, DAPEvent);
 wxDEFINE_EVENT(wxEVT_DAP_LAUNCH_RESPONSE, DAPEvent);
 wxDEFINE_EVENT(wxEVT_DAP_THREADS_RESPONSE, DAPEvent);
 
+wxDEFINE_EVENT(wxEVT_DAP_STOP_SNAPSHOT, DAPEvent);
+
 wxDEFINE_EVENT(wxEVT_DAP_RUN_IN_TERMINAL_REQUEST, DAPEvent);
 
 wxDEFINE_EVENT(wxEVT_DAP_STOPPED_EVENT, DAPEvent);
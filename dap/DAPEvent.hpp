@@ -27,6 +27,8 @@ public:
     dap::Event* GetDapEvent() const;
     dap::Response* GetDapResponse() const;
     dap::Request* GetDapRequest() const;
+    /// the object carried by events that are not protocol messages (e.g. a dap::StopSnapshot)
+    dap::Any* GetAnyObject() const { return m_object.get(); }
 };
 
 typedef void (wxEvtHandler::*DAPEventFunction)(DAPEvent&);
@@ -47,6 +49,9 @@ wxDECLARE_EXPORTED_EVENT(WXDLLIMPEXP_DAP, wxEVT_DAP_CONFIGURARIONE_DONE_RESPONSE
 wxDECLARE_EXPORTED_EVENT(WXDLLIMPEXP_DAP, wxEVT_DAP_LAUNCH_RESPONSE, DAPEvent);
 wxDECLARE_EXPORTED_EVENT(WXDLLIMPEXP_DAP, wxEVT_DAP_THREADS_RESPONSE, DAPEvent);
 
+/// carries a dap::StopSnapshot, see Client::SetPrefetchOnStop()
+wxDECLARE_EXPORTED_EVENT(WXDLLIMPEXP_DAP, wxEVT_DAP_STOP_SNAPSHOT, DAPEvent);
+
 wxDECLARE_EXPORTED_EVENT(WXDLLIMPEXP_DAP, wxEVT_DAP_RUN_IN_TERMINAL_REQUEST, DAPEvent);
 
 wxDECLARE_EXPORTED_EVENT(WXDLLIMPEXP_DAP, wxEVT_DAP_STOPPED_EVENT, DAPEvent);
@@ -0,0 +1,172 @@
+#ifndef DAP_FUTURE_HPP
+#define DAP_FUTURE_HPP
+
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace dap
+{
+template <typename T>
+class Future;
+
+namespace detail
+{
+template <typename T>
+struct FutureState {
+    bool completed = false;
+    std::shared_ptr<T> value;
+    std::vector<std::function<void(const std::shared_ptr<T>&)>> continuations;
+
+    void Complete(std::shared_ptr<T> result)
+    {
+        if (completed) {
+            return;
+        }
+        completed = true;
+        value = std::move(result);
+        auto pending = std::move(continuations);
+        continuations.clear();
+        for (auto& continuation : pending) {
+            continuation(value);
+        }
+    }
+};
+
+template <typename T>
+struct IsFuture : std::false_type {
+};
+
+template <typename T>
+struct IsFuture<Future<T>> : std::true_type {
+};
+} // namespace detail
+
+/// The writing side of a Future.
+///
+/// A promise that is destroyed before `SetValue()` was called (e.g. the client was reset while the request was in
+/// flight) completes its future with a null value, so continuations always run
+template <typename T>
+class Promise
+{
+    std::shared_ptr<detail::FutureState<T>> m_state;
+
+public:
+    Promise()
+        : m_state(std::make_shared<detail::FutureState<T>>())
+    {
+    }
+    ~Promise()
+    {
+        if (m_state) {
+            m_state->Complete(nullptr);
+        }
+    }
+
+    Promise(Promise&&) = default;
+    Promise(const Promise&) = delete;
+    Promise& operator=(const Promise&) = delete;
+    Promise& operator=(Promise&&) = delete;
+
+    Future<T> GetFuture() const { return Future<T>(m_state); }
+
+    /**
+     * @brief complete the future with `value` and run its continuations. Only the first call has an effect
+     */
+    void SetValue(std::shared_ptr<T> value) { m_state->Complete(std::move(value)); }
+};
+
+/// The eventual result of an asynchronous operation, e.g. the response to a request sent with `dap::Client`.
+///
+/// Unlike `std::future`, a Future is never waited on: the client completes it from the main thread (the one
+/// processing the responses), which must not block. Instead, register what to do with the result with `Then()`.
+/// A default constructed Future is already completed with a null value (e.g. a request that could not be sent).
+/// Futures are not thread safe, use them from the thread that runs the client
+template <typename T>
+class Future
+{
+    std::shared_ptr<detail::FutureState<T>> m_state;
+
+    void OnComplete(std::function<void(const std::shared_ptr<T>&)> continuation) const
+    {
+        if (!m_state) {
+            continuation(nullptr);
+        } else if (m_state->completed) {
+            continuation(m_state->value);
+        } else {
+            m_state->continuations.push_back(std::move(continuation));
+        }
+    }
+
+public:
+    typedef T value_type;
+
+    Future() {}
+    explicit Future(std::shared_ptr<detail::FutureState<T>> state)
+        : m_state(std::move(state))
+    {
+    }
+
+    /**
+     * @brief has the result arrived?
+     */
+    bool IsReady() const { return !m_state || m_state->completed; }
+
+    /**
+     * @brief the result. Null until IsReady() returns true, or if the operation failed
+     */
+    std::shared_ptr<T> Get() const { return m_state ? m_state->value : nullptr; }
+
+    /**
+     * @brief call `f(std::shared_ptr<T>)` with the result once it arrives (right away if it already did).
+     * If `f` returns a `Future<U>` (e.g. it sends a follow up request), `Then()` returns a `Future<U>` completed with
+     * the result of that future, so requests can be chained without nesting. Otherwise it returns this future
+     */
+    template <typename F>
+    auto Then(F f) const
+    {
+        typedef std::invoke_result_t<F, std::shared_ptr<T>> R;
+        if constexpr (detail::IsFuture<R>::value) {
+            typedef typename R::value_type U;
+            auto promise = std::make_shared<Promise<U>>();
+            Future<U> chained = promise->GetFuture();
+            OnComplete([f, promise](const std::shared_ptr<T>& value) mutable {
+                f(value).Then([promise](const std::shared_ptr<U>& result) { promise->SetValue(result); });
+            });
+            return chained;
+        } else {
+            OnComplete([f](const std::shared_ptr<T>& value) mutable { f(value); });
+            return *this;
+        }
+    }
+};
+
+/**
+ * @brief return a future completed once all of `futures` are, with their results in the same order
+ */
+template <typename T>
+Future<std::vector<std::shared_ptr<T>>> WhenAll(const std::vector<Future<T>>& futures)
+{
+    typedef std::vector<std::shared_ptr<T>> Results;
+    auto promise = std::make_shared<Promise<Results>>();
+    auto results = std::make_shared<Results>(futures.size());
+    auto remaining = std::make_shared<size_t>(futures.size());
+    Future<Results> all = promise->GetFuture();
+    if (futures.empty()) {
+        promise->SetValue(results);
+        return all;
+    }
+    for (size_t i = 0; i < futures.size(); ++i) {
+        futures[i].Then([promise, results, remaining, i](const std::shared_ptr<T>& value) {
+            (*results)[i] = value;
+            if (--(*remaining) == 0) {
+                promise->SetValue(results);
+            }
+        });
+    }
+    return all;
+}
+} // namespace dap
+#endif // DAP_FUTURE_HPP
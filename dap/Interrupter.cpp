@@ -0,0 +1,120 @@
+#include "Interrupter.hpp"
+
+#include "Exception.hpp"
+
+#include <cstdint>
+
+#ifdef _WIN32
+#include <ws2tcpip.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/eventfd.h>
+#endif
+#endif
+
+namespace dap
+{
+#ifdef _WIN32
+Interrupter::Interrupter()
+{
+    // a UDP socket bound to the loopback interface and connected to itself: sending a datagram makes it readable
+    m_readHandle = ::socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (m_readHandle == INVALID_SOCKET) {
+        throw Exception("Interrupter: failed to create socket: " + Socket::error());
+    }
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    int len = sizeof(addr);
+    if (::bind(m_readHandle, (sockaddr*)&addr, sizeof(addr)) != 0 ||
+        ::getsockname(m_readHandle, (sockaddr*)&addr, &len) != 0 ||
+        ::connect(m_readHandle, (sockaddr*)&addr, sizeof(addr)) != 0) {
+        wxString err = Socket::error();
+        ::closesocket(m_readHandle);
+        throw Exception("Interrupter: failed to setup socket: " + err);
+    }
+    u_long nonblocking = 1;
+    ::ioctlsocket(m_readHandle, FIONBIO, &nonblocking);
+    m_writeHandle = m_readHandle;
+}
+
+Interrupter::~Interrupter() { ::closesocket(m_readHandle); }
+
+void Interrupter::Signal()
+{
+    char ch = 0;
+    ::send(m_writeHandle, &ch, 1, 0);
+}
+
+void Interrupter::Clear()
+{
+    char buffer[64];
+    while (::recv(m_readHandle, buffer, sizeof(buffer), 0) > 0) {
+    }
+}
+
+#elif defined(__linux__)
+Interrupter::Interrupter()
+{
+    m_readHandle = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_readHandle == INVALID_SOCKET) {
+        throw Exception("Interrupter: eventfd failed: " + Socket::error());
+    }
+    m_writeHandle = m_readHandle;
+}
+
+Interrupter::~Interrupter() { ::close(m_readHandle); }
+
+void Interrupter::Signal()
+{
+    uint64_t one = 1;
+    ssize_t rc = ::write(m_writeHandle, &one, sizeof(one));
+    (void)rc; // a full counter is still readable, nothing to do on failure
+}
+
+void Interrupter::Clear()
+{
+    uint64_t count = 0;
+    ssize_t rc = ::read(m_readHandle, &count, sizeof(count));
+    (void)rc;
+}
+
+#else
+Interrupter::Interrupter()
+{
+    int fds[2];
+    if (::pipe(fds) != 0) {
+        throw Exception("Interrupter: pipe failed: " + Socket::error());
+    }
+    for (int fd : fds) {
+        ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+        ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+    }
+    m_readHandle = fds[0];
+    m_writeHandle = fds[1];
+}
+
+Interrupter::~Interrupter()
+{
+    ::close(m_readHandle);
+    ::close(m_writeHandle);
+}
+
+void Interrupter::Signal()
+{
+    char ch = 0;
+    ssize_t rc = ::write(m_writeHandle, &ch, 1);
+    (void)rc; // a full pipe is still readable, nothing to do on failure
+}
+
+void Interrupter::Clear()
+{
+    char buffer[64];
+    while (::read(m_readHandle, buffer, sizeof(buffer)) > 0) {
+    }
+}
+#endif
+} // namespace dap
@@ -0,0 +1,45 @@
+#ifndef DAP_INTERRUPTER_HPP
+#define DAP_INTERRUPTER_HPP
+
+#include "Socket.hpp"
+#include "dap_exports.hpp"
+
+namespace dap
+{
+/// A pollable handle used to wake up a thread blocked in `poll()` from another thread.
+///
+/// `Signal()` makes `GetHandle()` readable until `Clear()` is called. The implementation is an eventfd on Linux, a
+/// non-blocking self-pipe on other POSIX systems and a loopback UDP socket connected to itself on Windows (where
+/// `WSAPoll()` only accepts sockets)
+class WXDLLIMPEXP_DAP Interrupter
+{
+    socket_t m_readHandle = INVALID_SOCKET;
+    socket_t m_writeHandle = INVALID_SOCKET;
+
+public:
+    /**
+     * @throws Exception if the handle could not be created
+     */
+    Interrupter();
+    ~Interrupter();
+
+    Interrupter(const Interrupter&) = delete;
+    Interrupter& operator=(const Interrupter&) = delete;
+
+    /**
+     * @brief wake up the thread polling `GetHandle()`. Can be called from any thread
+     */
+    void Signal();
+
+    /**
+     * @brief consume all pending signals
+     */
+    void Clear();
+
+    /**
+     * @brief the handle to poll for read
+     */
+    socket_t GetHandle() const { return m_readHandle; }
+};
+} // namespace dap
+#endif // DAP_INTERRUPTER_HPP
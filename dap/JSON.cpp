@@ -25,23 +25,39 @@
 namespace dap
 {
 #define CHECK_IS_CONTAINER()        \
-    if(!m_cjson) {                  \
+    if(!m_cjson || m_arena) {       \
         return Json(nullptr);       \
     }                               \
     if(!IsArray() && !IsObject()) { \
         return Json(m_cjson);       \
     }
 
-Json::Json(cJsonDap* ptr)
+JsonArena::JsonArena(size_t blockSize)
+    : m_arena(cJSON_ArenaCreate(blockSize))
+{
+    m_refCount.store(1);
+}
+
+JsonArena::~JsonArena() { cJSON_ArenaDelete(m_arena); }
+
+void JsonArena::DecRef()
+{
+    if(--m_refCount == 0) {
+        delete this;
+    }
+}
+
+Json::Json(cJsonDap* ptr, JsonArena* arena)
     : m_cjson(ptr)
+    , m_arena(arena)
 {
 }
 
 void Json::DecRef()
 {
+    // copies of a tree parsed on the reader thread are released on both threads: decrement and test in one step
     if(m_refCount) {
-        (*m_refCount)--;
-        if(m_refCount->load() == 0) {
+        if(--(*m_refCount) == 0) {
             // Releas the underlying pointer
             Delete();
             delete m_refCount;
@@ -81,6 +97,7 @@ Json& Json::operator=(const Json& other)
     DecRef();
     m_refCount = other.m_refCount;
     m_cjson = other.m_cjson;
+    m_arena = other.m_arena;
     // Increase the ref count if needed
     IncRef();
     return *this;
@@ -96,23 +113,22 @@ Json::~Json()
 
 Json Json::operator[](const wxString& index) const
 {
-    if(m_cjson == nullptr) {
-        return Json(nullptr);
-    }
+    auto cb = index.mb_str(wxConvUTF8);
+    return (*this)[std::string_view(cb.data(), cb.length())];
+}
 
-    cJsonDap* child = m_cjson->child;
-    while(child) {
-        if(child->string && strcmp(child->string, index.c_str()) == 0) {
-            return Json(child);
-        }
-        child = child->next;
+Json Json::operator[](std::string_view index) const
+{
+    if(m_cjson == nullptr || m_cjson->type != cJsonDap_Object) {
+        return Json(nullptr);
     }
-    return Json(nullptr);
+    cJsonDap* child = cJSON_FindObjectItem(m_cjson, index.data(), index.length());
+    return Json(child, m_arena);
 }
 
 Json Json::AddItem(const wxString& name, cJsonDap* item)
 {
-    if(m_cjson == nullptr) {
+    if(m_cjson == nullptr || m_arena) {
         cJSON_Delete(item);
         return Json(nullptr);
     }
@@ -155,8 +171,13 @@ Json Json::CreateObject()
 
 void Json::Delete()
 {
-    // Delete only when owned
-    if(m_cjson) {
+    if(m_arena) {
+        // the nodes belong to the arena, we only drop our reference to it
+        m_arena->DecRef();
+        m_arena = nullptr;
+        m_cjson = nullptr;
+    } else if(m_cjson) {
+        // Delete only when owned
         cJSON_Delete(m_cjson);
         m_cjson = nullptr;
     }
@@ -201,6 +222,14 @@ Json Json::Add(const char* name, bool value)
 }
 
 wxString Json::GetString(const wxString& defaultVaule) const
+{
+    if(!m_cjson || m_cjson->type != cJsonDap_String) {
+        return defaultVaule;
+    }
+    return wxString::FromUTF8(m_cjson->valuestring);
+}
+
+std::string_view Json::GetStringView(std::string_view defaultVaule) const
 {
     if(!m_cjson || m_cjson->type != cJsonDap_String) {
         return defaultVaule;
@@ -243,7 +272,7 @@ Json Json::operator[](size_t index) const
         child = child->next;
         ++where;
     }
-    return Json(child);
+    return Json(child, m_arena);
 }
 
 size_t Json::GetCount() const
@@ -262,7 +291,7 @@ size_t Json::GetCount() const
 
 Json Json::AddObject(const char* name, const Json& obj)
 {
-    if(!m_cjson) {
+    if(!m_cjson || m_arena || obj.m_arena) {
         return obj;
     }
     cJSON_AddItemToObject(m_cjson, name, obj.m_cjson);
@@ -302,6 +331,9 @@ Json Json::Add(const char* name, const Json& value)
     if(IsObject()) {
         return AddObject(name, value);
     } else {
+        if(value.m_arena) {
+            return value;
+        }
         if(value.IsManaged()) {
             Json& o = const_cast<Json&>(value);
             o.UnManage(); // We take ownership
@@ -311,9 +343,39 @@ Json Json::Add(const char* name, const Json& value)
     }
 }
 
-Json Json::Parse(const wxString& source)
+Json Json::Parse(const wxString& source) { return Parse(source.mb_str(wxConvUTF8).data()); }
+
+Json Json::Parse(const char* source)
+{
+    Json json(cJSON_Parse(source));
+    json.Manage();
+    return json;
+}
+
+Json Json::Parse(std::string_view source)
 {
-    Json json(cJSON_Parse(source.c_str()));
+    Json json(cJSON_ParseWithLength(source.data(), source.length(), nullptr));
+    json.Manage();
+    return json;
+}
+
+Json Json::Parse(const char* source, JsonArena* arena)
+{
+    return Json::Wrap(cJSON_ParseWithArena(source, arena->GetArena()), arena);
+}
+
+Json Json::Parse(std::string_view source, JsonArena* arena)
+{
+    return Json::Wrap(cJSON_ParseWithLength(source.data(), source.length(), arena->GetArena()), arena);
+}
+
+Json Json::Wrap(cJsonDap* root, JsonArena* arena)
+{
+    if(!root) {
+        return Json(nullptr);
+    }
+    Json json(root, arena);
+    arena->IncRef();
     json.Manage();
     return json;
 }
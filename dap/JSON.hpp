@@ -29,6 +29,7 @@
 #include <atomic>
 #include <cstring>
 #include <memory>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 #include <wx/arrstr.h>
@@ -36,13 +37,53 @@
 
 namespace dap
 {
+/// Owns the memory of the Json trees parsed with `Json::Parse(source, arena)`.
+/// The arena is reference counted: its creator holds one reference and every parsed tree holds another until the
+/// last Json copy of that tree goes away. Use `IsShared()` to tell whether it can be recycled with `Reset()`
+class WXDLLIMPEXP_DAP JsonArena
+{
+    cJsonDapArena* m_arena = nullptr;
+    std::atomic_int m_refCount;
+
+    ~JsonArena();
+
+public:
+    /// Releases the creator reference, for use with std::unique_ptr
+    struct Release {
+        void operator()(JsonArena* arena) const { arena->DecRef(); }
+    };
+    typedef std::unique_ptr<JsonArena, Release> Ptr_t;
+
+    explicit JsonArena(size_t blockSize = 64 * 1024);
+    JsonArena(const JsonArena&) = delete;
+    JsonArena& operator=(const JsonArena&) = delete;
+
+    void IncRef() { ++m_refCount; }
+    void DecRef();
+
+    /**
+     * @brief is there a parsed tree still referencing this arena?
+     */
+    bool IsShared() const { return m_refCount.load() > 1; }
+
+    /**
+     * @brief release all the trees allocated from this arena. Only call this when `IsShared()` is false
+     */
+    void Reset() { cJSON_ArenaReset(m_arena); }
+    cJsonDapArena* GetArena() const { return m_arena; }
+};
+
 struct WXDLLIMPEXP_DAP Json {
     cJsonDap* m_cjson = nullptr;
     std::atomic_int* m_refCount = nullptr;
+    // non null when the tree was allocated from an arena. Such trees are read-only
+    JsonArena* m_arena = nullptr;
 
 private:
-    Json(cJsonDap* ptr);
+    Json(cJsonDap* ptr, JsonArena* arena = nullptr);
     Json AddItem(const wxString& name, cJsonDap* item);
+    /// take a reference on `arena` and return a managed Json for `root`
+    static Json Wrap(cJsonDap* root, JsonArena* arena);
 
     void DecRef();
     void IncRef();
@@ -69,7 +110,18 @@ public:
         if(m_cjson == nullptr || !m_cjson->string) {
             return "";
         }
-        return wxString(m_cjson->string);
+        return wxString::FromUTF8(m_cjson->string);
+    }
+
+    /**
+     * @brief return the property name as UTF-8. The view is valid for as long as the tree is alive
+     */
+    std::string_view GetNameView() const
+    {
+        if(m_cjson == nullptr || !m_cjson->string) {
+            return {};
+        }
+        return m_cjson->string;
     }
 
     /**
@@ -97,9 +149,38 @@ public:
     static Json Parse(const wxString& source);
 
     /**
-     * @brief object property access
+     * @brief create Json from a NULL terminated UTF-8 buffer
+     */
+    static Json Parse(const char* source);
+    static Json Parse(const std::string& source) { return Parse(source.c_str()); }
+
+    /**
+     * @brief create Json from a UTF-8 buffer that does not need to be NULL terminated.
+     * Prefer the `const char*` overload when the buffer is terminated, this one has to copy it once
+     */
+    static Json Parse(std::string_view source);
+
+    /**
+     * @brief create Json from a NULL terminated UTF-8 buffer, allocating the entire tree from `arena`.
+     * This is considerably cheaper than the heap based parse, but the result is read-only: the Add*() methods
+     * are no-ops on it and it can not be added to another Json
+     */
+    static Json Parse(const char* source, JsonArena* arena);
+    static Json Parse(std::string_view source, JsonArena* arena);
+
+    /**
+     * @brief is this Json part of an arena allocated (read-only) tree?
+     */
+    bool IsArenaBacked() const { return m_arena != nullptr; }
+
+    /**
+     * @brief object property access. The lookup is case sensitive. Parsed objects with more than a few members are
+     * indexed while parsing, so the cost of a lookup does not depend on the number of members. Objects built in
+     * memory are searched linearly
      */
     Json operator[](const wxString& index) const;
+    Json operator[](const char* index) const { return (*this)[std::string_view(index)]; }
+    Json operator[](std::string_view index) const;
 
     /**
      * @brief index access
@@ -139,6 +220,12 @@ public:
      */
     wxString GetString(const wxString& defaultVaule = "") const;
 
+    /**
+     * @brief return value as UTF-8, without copying or converting it.
+     * The view points into the tree and is valid for as long as the tree is alive
+     */
+    std::string_view GetStringView(std::string_view defaultVaule = {}) const;
+
     /**
      * @brief return value as number
      */
@@ -3,61 +3,99 @@
 #include "Exception.hpp"
 #include "Log.hpp"
 #include "SocketServer.hpp"
-#include "StringUtils.hpp"
 
+#include <cctype>
+#include <climits>
+#include <cstdio>
+#include <cstring>
 #include <iostream>
 
+namespace
+{
+// header names are case insensitive, keep this one in lowercase
+constexpr std::string_view CONTENT_LENGTH = "content-length";
+
+// room reserved in front of an outgoing payload for "Content-Length: <20 digits>\r\n\r\n"
+constexpr size_t HEADER_RESERVE = 48;
+} // namespace
+
 dap::JsonRPC::JsonRPC() {}
 
 dap::JsonRPC::~JsonRPC() {}
 
 dap::Json dap::JsonRPC::DoProcessBuffer()
 {
-    if (m_buffer.empty()) {
-        return {};
-    }
+    while (!m_buffer.IsEmpty()) {
+        if (!ReadHeaders()) {
+            // incomplete header section, the parser resumes from where it stopped once more data arrives
+            return {};
+        }
 
-    // Find the "Content-Length:" string
-    std::unordered_map<std::string, std::string> headers;
-    int headerSize = ReadHeaders(headers);
-    if (headerSize == -1) {
-        return {};
-    }
+        size_t headerSize = m_headerScanned;
+        if (m_contentLength <= 0) {
+            // this is a problem in the protocol. If we keep this section in the buffer we will simply get
+            // stuck with it again later. So we remove it and move on to the next message
+            LOG_ERROR() << "ERROR: Read complete header section. But no valid Content-Length header was found"
+                        << endl;
+            m_buffer.Consume(headerSize);
+            ResetHeaders();
+            continue;
+        }
 
-    LOG_DEBUG() << "Headers:" << headers.size() << endl;
-    for (const auto& [k, v] : headers) {
-        LOG_DEBUG() << k << ":" << v << endl;
-    }
+        size_t messageEnd = headerSize + m_contentLength;
+        if (messageEnd > m_buffer.ReadableBytes()) {
+            // not enough buffer
+            return {};
+        }
 
-    // We got the headers, check to see that we have the "Content-Length" one
-    auto iter = headers.find("Content-Length");
-    if (iter == headers.end()) {
-        // this is a problem in the protocol. If we restore this section back to the buffer
-        // we will simply stuck with it again later. So we remove it and return null
-        m_buffer.erase(headerSize);
-        LOG_ERROR() << "ERROR: Read complete header section. But no Content-Length header was found" << endl;
-        return {};
-    }
+        // Parse the payload directly from the buffer: terminate it in place (restoring the overwritten byte
+        // afterwards) and move the read cursor past the message. No copy, no memmove
+        char saved = m_buffer.Terminate(messageEnd);
+        Json json = Json::Parse(m_buffer.ReadPtr() + headerSize, AcquireArena());
+        m_buffer.Restore(messageEnd, saved);
+        m_buffer.Consume(messageEnd);
+        ResetHeaders();
 
-    std::string contentLength = iter->second;
-    long msglen = std::atol(contentLength.c_str());
-    if (msglen <= 0) {
-        LOG_ERROR() << "ERROR: Invalid Content-Length header value: 0 or lower than 0" << endl;
-        return {};
+        if (json.IsOK()) {
+            return json;
+        }
+        LOG_ERROR() << "ERROR: failed to parse JSON payload of size:" << (long)m_contentLength << endl;
     }
+    return {};
+}
 
-    long buflen = m_buffer.length();
-    if ((headerSize + msglen) > buflen) {
-        LOG_INFO() << "Not enough buffer" << endl;
-        // not enough buffer
-        return {};
-    }
+std::string_view dap::JsonRPC::Serialize(const ProtocolMessage& msg) const
+{
+    // the header length depends on the payload length, which we only know once the payload is written: reserve the
+    // maximum header size, write the payload after it and then place the header right in front of the payload
+    m_output.Clear();
+    m_output.PrepareWrite(HEADER_RESERVE + 256);
+    m_output.Commit(HEADER_RESERVE);
+
+    JsonWriter writer(m_output);
+    msg.Write(writer);
 
-    // Read the payload into a separate buffer and remove the full message
-    // from the m_buffer member
-    std::string payload(m_buffer.begin() + headerSize, m_buffer.begin() + headerSize + msglen);
-    m_buffer.erase(0, headerSize + msglen);
-    return Json::Parse(payload);
+    size_t payload_size = m_output.ReadableBytes() - HEADER_RESERVE;
+    char header[HEADER_RESERVE];
+    int header_size = snprintf(header, sizeof(header), "Content-Length: %zu\r\n\r\n", payload_size);
+    size_t offset = HEADER_RESERVE - header_size;
+    std::memcpy(m_output.ReadPtr() + offset, header, header_size);
+    m_output.Consume(offset);
+    return std::string_view(m_output.ReadPtr(), m_output.ReadableBytes());
+}
+
+dap::JsonArena* dap::JsonRPC::AcquireArena()
+{
+    if (m_arena && m_arena->IsShared()) {
+        // a previous message is still alive, the arena will be released together with it
+        m_arena.reset();
+    }
+    if (m_arena) {
+        m_arena->Reset();
+    } else {
+        m_arena.reset(new JsonArena());
+    }
+    return m_arena.get();
 }
 
 void dap::JsonRPC::ProcessBuffer(std::function<void(const Json&, wxObject*)> callback, wxObject* o)
@@ -71,24 +109,100 @@ void dap::JsonRPC::ProcessBuffer(std::function<void(const Json&, wxObject*)> cal
     }
 }
 
-int dap::JsonRPC::ReadHeaders(unordered_map<std::string, std::string>& headers)
+void dap::JsonRPC::ResetHeaders()
 {
-    size_t where = m_buffer.find("\r\n\r\n");
-    if (where == wxString::npos) {
-        return -1;
-    }
-    std::string headerSection = m_buffer.substr(0, where); // excluding the "\r\n\r\n"
-    std::vector<std::string> lines = DapStringUtils::Split(headerSection, "\n");
-    for (std::string& header : lines) {
-        DapStringUtils::Trim(header);
-        std::string name = DapStringUtils::BeforeFirst(header, ':');
-        std::string value = DapStringUtils::AfterFirst(header, ':');
-        headers.insert({ DapStringUtils::Trim(name), DapStringUtils::Trim(value) });
+    m_headerState = eHeaderState::kLineStart;
+    m_headerScanned = 0;
+    m_nameMatched = 0;
+    m_contentLength = -1;
+}
+
+bool dap::JsonRPC::ReadHeaders()
+{
+    const char* data = m_buffer.ReadPtr();
+    size_t count = m_buffer.ReadableBytes();
+    while (m_headerState != eHeaderState::kDone && m_headerScanned < count) {
+        char ch = data[m_headerScanned++];
+        switch (m_headerState) {
+        case eHeaderState::kLineStart:
+            if (ch == '\r') {
+                m_headerState = eHeaderState::kEmptyLine;
+                break;
+            } else if (ch == '\n') {
+                // be forgiving and accept "\n" as the line terminator
+                m_headerState = eHeaderState::kDone;
+                break;
+            }
+            m_nameMatched = 0;
+            m_headerState = eHeaderState::kName;
+            // fall through
+        case eHeaderState::kName:
+            if (ch == ':') {
+                m_headerState =
+                    m_nameMatched == CONTENT_LENGTH.length() ? eHeaderState::kValueStart : eHeaderState::kSkipLine;
+            } else if (ch == '\n') {
+                m_headerState = eHeaderState::kLineStart;
+            } else if (m_nameMatched < CONTENT_LENGTH.length() &&
+                       ::tolower(static_cast<unsigned char>(ch)) == CONTENT_LENGTH[m_nameMatched]) {
+                ++m_nameMatched;
+            } else if (m_nameMatched != CONTENT_LENGTH.length() || (ch != ' ' && ch != '\t')) {
+                // some other header
+                m_headerState = eHeaderState::kSkipLine;
+            }
+            break;
+        case eHeaderState::kValueStart:
+            if (ch >= '0' && ch <= '9') {
+                m_contentLength = ch - '0';
+                m_headerState = eHeaderState::kValue;
+            } else if (ch == '\n') {
+                m_headerState = eHeaderState::kLineStart;
+            } else if (ch != ' ' && ch != '\t') {
+                m_headerState = eHeaderState::kSkipLine;
+            }
+            break;
+        case eHeaderState::kValue:
+            if (ch >= '0' && ch <= '9') {
+                if (m_contentLength > (LONG_MAX - 9) / 10) {
+                    // overflow
+                    m_contentLength = -1;
+                    m_headerState = eHeaderState::kSkipLine;
+                } else {
+                    m_contentLength = m_contentLength * 10 + (ch - '0');
+                }
+            } else {
+                m_headerState = (ch == '\n') ? eHeaderState::kLineStart : eHeaderState::kSkipLine;
+            }
+            break;
+        case eHeaderState::kSkipLine:
+            if (ch == '\n') {
+                m_headerState = eHeaderState::kLineStart;
+            }
+            break;
+        case eHeaderState::kEmptyLine:
+            m_headerState = (ch == '\n') ? eHeaderState::kDone : eHeaderState::kSkipLine;
+            break;
+        case eHeaderState::kDone:
+            break;
+        }
     }
-    // return the headers section + the separator
-    return (where + 4);
+    return m_headerState == eHeaderState::kDone;
+}
+
+void dap::JsonRPC::SetBuffer(const std::string& buffer)
+{
+    m_buffer.Clear();
+    ResetHeaders();
+    m_buffer.Append(buffer);
 }
 
-void dap::JsonRPC::SetBuffer(const std::string& buffer) { m_buffer = buffer; }
+void dap::JsonRPC::AppendBuffer(const std::string& buffer) { m_buffer.Append(buffer); }
 
-void dap::JsonRPC::AppendBuffer(const std::string& buffer) { m_buffer.append(buffer); }
+void dap::JsonRPC::AppendBuffer(ByteBuffer& buffer)
+{
+    if (m_buffer.IsEmpty()) {
+        std::swap(m_buffer, buffer);
+    } else {
+        m_buffer.Append(buffer.View());
+    }
+    buffer.Clear();
+}
@@ -1,6 +1,7 @@
 #ifndef DAPJSONRPC_HPP
 #define DAPJSONRPC_HPP
 
+#include "ByteBuffer.hpp"
 #include "Exception.hpp"
 #include "Queue.hpp"
 #include "dap.hpp"
@@ -8,8 +9,10 @@
 
 #include <atomic>
 #include <string>
+#include <string_view>
 #include <thread>
-#include <unordered_map>
+#include <type_traits>
+#include <utility>
 #include <wx/object.h>
 
 namespace dap
@@ -17,15 +20,53 @@ namespace dap
 class WXDLLIMPEXP_DAP JsonRPC
 {
 protected:
-    std::string m_buffer;
+    /// States of the incremental header parser
+    enum class eHeaderState {
+        kLineStart,  // at the start of a header line
+        kName,       // reading a header name
+        kValueStart, // skipping the spaces that follow "Content-Length:"
+        kValue,      // reading the Content-Length digits
+        kSkipLine,   // ignoring the remainder of the current line
+        kEmptyLine,  // read a '\r' at the start of a line
+        kDone,       // the header section is complete
+    };
+
+    ByteBuffer m_buffer;
+    eHeaderState m_headerState = eHeaderState::kLineStart;
+    size_t m_headerScanned = 0;  // number of bytes (past the read cursor) already fed to the header parser
+    size_t m_nameMatched = 0;    // number of "content-length" characters matched on the current line
+    long m_contentLength = -1;   // -1 until a valid Content-Length header is read
+    JsonArena::Ptr_t m_arena;    // inbound payloads are parsed into this arena, see AcquireArena()
+    // outbound messages are serialized here, both are reused from one message to the next
+    mutable ByteBuffer m_output;
+
+    template <typename T, typename = void>
+    struct HasSendBatch : std::false_type {
+    };
+    template <typename T>
+    struct HasSendBatch<T, std::void_t<decltype(std::declval<T&>().SendBatch(nullptr, 0))>> : std::true_type {
+    };
 
 protected:
-    int ReadHeaders(std::unordered_map<std::string, std::string>& headers);
+    /**
+     * @brief feed the bytes that arrived since the previous call to the header parser.
+     * @return true once the header section (including the empty line) is complete
+     */
+    bool ReadHeaders();
+    void ResetHeaders();
     Json DoProcessBuffer();
 
+    /**
+     * @brief return an arena for parsing the next payload. The previous arena is recycled when none of the
+     * messages parsed into it is referenced anymore, otherwise it is left to its readers and a new one is created
+     */
+    JsonArena* AcquireArena();
+
 public:
     JsonRPC();
     ~JsonRPC();
+    JsonRPC(JsonRPC&&) = default;
+    JsonRPC& operator=(JsonRPC&&) = default;
 
     /**
      * @brief provide input buffer.
@@ -38,6 +79,12 @@ public:
      */
     void AppendBuffer(const std::string& buffer);
 
+    /**
+     * @brief move the content of `buffer` to the end of the existing buffer. When the internal buffer is empty the
+     * storage is swapped instead of copied: `buffer` is left empty, possibly holding the previous (reusable) storage
+     */
+    void AppendBuffer(ByteBuffer& buffer);
+
     /**
      * @brief Check if we have a complete Json message in the internal buffer and invoke callback
      * If successful, callback is called. Note that it will get called as long there are complete messages in the
@@ -48,8 +95,16 @@ public:
     void ProcessBuffer(std::function<void(const Json&, wxObject*)> callback, wxObject* o);
 
     /**
-     * @brief send protocol message over the network
-     * TransportPtr must have a Send(const std::string&) method
+     * @brief serialize `msg` (including its Content-Length header) into an internal buffer and return it.
+     * The message is written straight into the buffer with `ProtocolMessage::Write()`. The returned view is valid
+     * until the next call
+     */
+    std::string_view Serialize(const ProtocolMessage& msg) const;
+
+    /**
+     * @brief send protocol message over the network, straight from the serialization buffer.
+     * TransportPtr must have a SendBatch(const std::string_view*, size_t) or a Send(std::string_view) method
+     * @throws Exception when there is no connection, or SendBatch() did not accept the whole message
      */
     template <typename TransportPtr>
     void Send(ProtocolMessage& msg, TransportPtr conn) const
@@ -57,13 +112,15 @@ public:
         if (!conn) {
             throw Exception("Invalid connection");
         }
-        std::string network_buffer;
-        std::string payload = msg.ToString().ToStdString();
-        network_buffer = "Content-Length: ";
-        network_buffer += std::to_string(payload.length());
-        network_buffer += "\r\n\r\n";
-        network_buffer += payload;
-        conn->Send(network_buffer);
+        std::string_view frame = Serialize(msg);
+        if constexpr (HasSendBatch<std::remove_reference_t<decltype(*conn)>>::value) {
+            // transports report errors with a short count
+            if (conn->SendBatch(&frame, 1) < frame.size()) {
+                throw Exception("Send failed");
+            }
+        } else {
+            conn->Send(frame);
+        }
     }
 
     /**
@@ -0,0 +1,237 @@
+#include "JsonWriter.hpp"
+
+#include <cfloat>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+
+namespace dap
+{
+void JsonWriter::BeforeValue()
+{
+    if (m_afterKey) {
+        // the separator was written before the key
+        m_afterKey = false;
+        return;
+    }
+    if (!m_hasItems.empty()) {
+        if (m_hasItems.back()) {
+            m_out.Append(",", 1);
+        }
+        m_hasItems.back() = true;
+    }
+}
+
+JsonWriter& JsonWriter::BeginObject()
+{
+    BeforeValue();
+    m_out.Append("{", 1);
+    m_hasItems.push_back(false);
+    return *this;
+}
+
+JsonWriter& JsonWriter::EndObject()
+{
+    m_out.Append("}", 1);
+    m_hasItems.pop_back();
+    return *this;
+}
+
+JsonWriter& JsonWriter::BeginArray()
+{
+    BeforeValue();
+    m_out.Append("[", 1);
+    m_hasItems.push_back(false);
+    return *this;
+}
+
+JsonWriter& JsonWriter::EndArray()
+{
+    m_out.Append("]", 1);
+    m_hasItems.pop_back();
+    return *this;
+}
+
+JsonWriter& JsonWriter::Key(std::string_view name)
+{
+    BeforeValue();
+    WriteString(name.data(), name.length());
+    m_out.Append(":", 1);
+    m_afterKey = true;
+    return *this;
+}
+
+void JsonWriter::WriteString(const char* str, size_t len)
+{
+    // same escaping rules as cJSON's print_string_ptr()
+    static const char hex[] = "0123456789abcdef";
+    // worst case: every byte becomes \u00XX
+    char* p = m_out.PrepareWrite(len * 6 + 2);
+    char* start = p;
+    *p++ = '"';
+    for (size_t i = 0; i < len; ++i) {
+        unsigned char ch = static_cast<unsigned char>(str[i]);
+        if (ch > 31 && ch != '"' && ch != '\\') {
+            *p++ = static_cast<char>(ch);
+            continue;
+        }
+        *p++ = '\\';
+        switch (ch) {
+        case '\\':
+            *p++ = '\\';
+            break;
+        case '"':
+            *p++ = '"';
+            break;
+        case '\b':
+            *p++ = 'b';
+            break;
+        case '\f':
+            *p++ = 'f';
+            break;
+        case '\n':
+            *p++ = 'n';
+            break;
+        case '\r':
+            *p++ = 'r';
+            break;
+        case '\t':
+            *p++ = 't';
+            break;
+        default:
+            *p++ = 'u';
+            *p++ = '0';
+            *p++ = '0';
+            *p++ = hex[ch >> 4];
+            *p++ = hex[ch & 0xF];
+            break;
+        }
+    }
+    *p++ = '"';
+    m_out.Commit(p - start);
+}
+
+JsonWriter& JsonWriter::Value(std::string_view value)
+{
+    BeforeValue();
+    WriteString(value.data(), value.length());
+    return *this;
+}
+
+JsonWriter& JsonWriter::Value(const wxString& value)
+{
+    auto cb = value.mb_str(wxConvUTF8);
+    return Value(std::string_view(cb.data(), cb.length()));
+}
+
+JsonWriter& JsonWriter::Value(double value)
+{
+    // same formatting as cJSON's print_number()
+    BeforeValue();
+    char buffer[64];
+    int len;
+    bool is_int = value <= INT_MAX && value >= INT_MIN;
+    if (is_int && std::fabs(static_cast<double>(static_cast<int>(value)) - value) <= DBL_EPSILON) {
+        len = snprintf(buffer, sizeof(buffer), "%d", static_cast<int>(value));
+    } else if (std::fabs(std::floor(value) - value) <= DBL_EPSILON) {
+        len = snprintf(buffer, sizeof(buffer), "%.0f", value);
+    } else if (std::fabs(value) < 1.0e-6 || std::fabs(value) > 1.0e9) {
+        len = snprintf(buffer, sizeof(buffer), "%e", value);
+    } else {
+        len = snprintf(buffer, sizeof(buffer), "%f", value);
+    }
+    m_out.Append(buffer, len > 0 ? static_cast<size_t>(len) : 0);
+    return *this;
+}
+
+JsonWriter& JsonWriter::Value(long value)
+{
+    BeforeValue();
+    char buffer[32];
+    int len = snprintf(buffer, sizeof(buffer), "%ld", value);
+    m_out.Append(buffer, len > 0 ? static_cast<size_t>(len) : 0);
+    return *this;
+}
+
+JsonWriter& JsonWriter::Value(size_t value)
+{
+    BeforeValue();
+    char buffer[32];
+    int len = snprintf(buffer, sizeof(buffer), "%zu", value);
+    m_out.Append(buffer, len > 0 ? static_cast<size_t>(len) : 0);
+    return *this;
+}
+
+JsonWriter& JsonWriter::Value(bool value)
+{
+    BeforeValue();
+    if (value) {
+        m_out.Append("true", 4);
+    } else {
+        m_out.Append("false", 5);
+    }
+    return *this;
+}
+
+JsonWriter& JsonWriter::Value(const std::vector<wxString>& value)
+{
+    BeginArray();
+    for (const auto& s : value) {
+        Value(s);
+    }
+    return EndArray();
+}
+
+JsonWriter& JsonWriter::Null()
+{
+    BeforeValue();
+    m_out.Append("null", 4);
+    return *this;
+}
+
+JsonWriter& JsonWriter::Value(const Json& value)
+{
+    if (!value.IsOK()) {
+        // Json::ToString() of an invalid Json is an empty string, the closest valid equivalent is null
+        return Null();
+    }
+    WriteNode(value.m_cjson);
+    return *this;
+}
+
+void JsonWriter::WriteNode(const cJsonDap* node)
+{
+    switch (node->type & 255) {
+    case cJsonDap_Null:
+        Null();
+        break;
+    case cJsonDap_False:
+        Value(false);
+        break;
+    case cJsonDap_True:
+        Value(true);
+        break;
+    case cJsonDap_Number:
+        Value(node->valuedouble);
+        break;
+    case cJsonDap_String:
+        Value(std::string_view(node->valuestring ? node->valuestring : ""));
+        break;
+    case cJsonDap_Array:
+        BeginArray();
+        for (const cJsonDap* child = node->child; child; child = child->next) {
+            WriteNode(child);
+        }
+        EndArray();
+        break;
+    case cJsonDap_Object:
+        BeginObject();
+        for (const cJsonDap* child = node->child; child; child = child->next) {
+            Key(child->string ? child->string : "");
+            WriteNode(child);
+        }
+        EndObject();
+        break;
+    }
+}
+} // namespace dap
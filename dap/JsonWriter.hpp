@@ -0,0 +1,78 @@
+#ifndef DAP_JSONWRITER_HPP
+#define DAP_JSONWRITER_HPP
+
+#include "ByteBuffer.hpp"
+#include "JSON.hpp"
+#include "dap_exports.hpp"
+
+#include <string_view>
+#include <vector>
+#include <wx/string.h>
+
+namespace dap
+{
+/// A streaming JSON serializer that writes straight into a ByteBuffer, without building a cJSON tree.
+/// The output is identical to `Json::ToString(false)` of the equivalent tree, so the two can be used interchangeably.
+///
+/// Usage:
+///     writer.BeginObject().Add("seq", 1).Add("command", "next");
+///     writer.Key("arguments").BeginObject().Add("threadId", 3).EndObject();
+///     writer.EndObject();
+///
+/// The writer does not validate the structure, it is up to the caller to balance the Begin/End calls and to call
+/// `Key()` before every value written into an object
+class WXDLLIMPEXP_DAP JsonWriter
+{
+    ByteBuffer& m_out;
+    std::vector<bool> m_hasItems; // per open container: was anything written into it yet?
+    bool m_afterKey = false;
+
+protected:
+    /// emit the ',' separating this value from the previous one, if needed
+    void BeforeValue();
+    void WriteString(const char* str, size_t len);
+    void WriteNode(const cJsonDap* node);
+
+public:
+    explicit JsonWriter(ByteBuffer& out)
+        : m_out(out)
+    {
+    }
+
+    JsonWriter& BeginObject();
+    JsonWriter& EndObject();
+    JsonWriter& BeginArray();
+    JsonWriter& EndArray();
+
+    /**
+     * @brief write the name of the next object member
+     */
+    JsonWriter& Key(std::string_view name);
+
+    JsonWriter& Value(std::string_view value);
+    JsonWriter& Value(const char* value) { return Value(std::string_view(value)); }
+    JsonWriter& Value(const wxString& value);
+    JsonWriter& Value(double value);
+    JsonWriter& Value(int value) { return Value(static_cast<long>(value)); }
+    JsonWriter& Value(long value);
+    JsonWriter& Value(size_t value);
+    JsonWriter& Value(bool value);
+    JsonWriter& Value(const std::vector<wxString>& value);
+    JsonWriter& Null();
+
+    /**
+     * @brief write an existing Json tree
+     */
+    JsonWriter& Value(const Json& value);
+
+    /**
+     * @brief write an object member, same as Key(name).Value(value)
+     */
+    template <typename T>
+    JsonWriter& Add(std::string_view name, const T& value)
+    {
+        return Key(name).Value(value);
+    }
+};
+} // namespace dap
+#endif // DAP_JSONWRITER_HPP
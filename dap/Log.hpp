@@ -4,6 +4,7 @@
 #include "dap_exports.hpp"
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <wx/arrstr.h>
 #include <wx/string.h>
@@ -116,6 +117,14 @@ public:
         return *this;
     }
 
+    inline Log& Append(std::string_view elem, int level)
+    {
+        if(level > m_verbosity) {
+            return *this;
+        }
+        return Append(wxString::FromUTF8(elem.data(), elem.length()), level);
+    }
+
     /**
      * @brief flush the logger content
      */
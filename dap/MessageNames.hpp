@@ -0,0 +1,169 @@
+#ifndef DAP_MESSAGENAMES_HPP
+#define DAP_MESSAGENAMES_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+/// The DAP command and event names known to the library (specification names, including those we don't implement
+/// a class for, so applications can hook them). The list is turned into `dap::eMessageName` and into a perfect hash
+/// table computed at compile time, mapping a name to its id with one hash and a single string compare
+// clang-format off
+#define DAP_MESSAGE_NAMES(X)                                        \
+    X(kAttach, "attach")                                            \
+    X(kBreakpoint, "breakpoint")                                    \
+    X(kBreakpointLocations, "breakpointLocations")                  \
+    X(kCancel, "cancel")                                            \
+    X(kCapabilities, "capabilities")                                \
+    X(kCompletions, "completions")                                  \
+    X(kConfigurationDone, "configurationDone")                      \
+    X(kContinue, "continue")                                        \
+    X(kContinued, "continued")                                      \
+    X(kDataBreakpointInfo, "dataBreakpointInfo")                    \
+    X(kDebugpyWaitingForServer, "debugpyWaitingForServer")          \
+    X(kDisassemble, "disassemble")                                  \
+    X(kDisconnect, "disconnect")                                    \
+    X(kEvaluate, "evaluate")                                        \
+    X(kExceptionInfo, "exceptionInfo")                              \
+    X(kExited, "exited")                                            \
+    X(kGoto, "goto")                                                \
+    X(kGotoTargets, "gotoTargets")                                  \
+    X(kInitialize, "initialize")                                    \
+    X(kInitialized, "initialized")                                  \
+    X(kInvalidated, "invalidated")                                  \
+    X(kLaunch, "launch")                                            \
+    X(kLoadedSource, "loadedSource")                                \
+    X(kLoadedSources, "loadedSources")                              \
+    X(kMemory, "memory")                                            \
+    X(kModule, "module")                                            \
+    X(kModules, "modules")                                          \
+    X(kNext, "next")                                                \
+    X(kOutput, "output")                                            \
+    X(kPause, "pause")                                              \
+    X(kProcess, "process")                                          \
+    X(kProgressEnd, "progressEnd")                                  \
+    X(kProgressStart, "progressStart")                              \
+    X(kProgressUpdate, "progressUpdate")                            \
+    X(kReadMemory, "readMemory")                                    \
+    X(kRestart, "restart")                                          \
+    X(kRestartFrame, "restartFrame")                                \
+    X(kReverseContinue, "reverseContinue")                          \
+    X(kRunInTerminal, "runInTerminal")                              \
+    X(kScopes, "scopes")                                            \
+    X(kSetBreakpoints, "setBreakpoints")                            \
+    X(kSetDataBreakpoints, "setDataBreakpoints")                    \
+    X(kSetExceptionBreakpoints, "setExceptionBreakpoints")          \
+    X(kSetExpression, "setExpression")                              \
+    X(kSetFunctionBreakpoints, "setFunctionBreakpoints")            \
+    X(kSetInstructionBreakpoints, "setInstructionBreakpoints")      \
+    X(kSetVariable, "setVariable")                                  \
+    X(kSource, "source")                                            \
+    X(kStackTrace, "stackTrace")                                    \
+    X(kStep, "step")                                                \
+    X(kStepBack, "stepBack")                                        \
+    X(kStepIn, "stepIn")                                            \
+    X(kStepInTargets, "stepInTargets")                              \
+    X(kStepOut, "stepOut")                                          \
+    X(kStopped, "stopped")                                          \
+    X(kTerminate, "terminate")                                      \
+    X(kTerminated, "terminated")                                    \
+    X(kTerminateThreads, "terminateThreads")                        \
+    X(kThread, "thread")                                            \
+    X(kThreads, "threads")                                          \
+    X(kVariables, "variables")                                      \
+    X(kWriteMemory, "writeMemory")
+// clang-format on
+
+namespace dap
+{
+enum class eMessageName : uint8_t {
+    kUnknown = 0,
+#define DAP_MESSAGE_NAME_ENUM(Id, Name) Id,
+    DAP_MESSAGE_NAMES(DAP_MESSAGE_NAME_ENUM)
+#undef DAP_MESSAGE_NAME_ENUM
+        kCount,
+};
+
+namespace message_names
+{
+constexpr std::array<std::string_view, static_cast<size_t>(eMessageName::kCount)> kNames = {
+    std::string_view{},
+#define DAP_MESSAGE_NAME_STRING(Id, Name) std::string_view{ Name },
+    DAP_MESSAGE_NAMES(DAP_MESSAGE_NAME_STRING)
+#undef DAP_MESSAGE_NAME_STRING
+};
+
+/// number of slots in the hash table, must be a power of 2. Large enough (compared to the number of names) for a
+/// collision free seed to be found after a handful of attempts
+constexpr size_t kTableSize = 1024;
+
+constexpr uint32_t Hash(std::string_view name, uint32_t seed)
+{
+    // FNV-1a, with the seed mixed into the offset basis
+    uint32_t h = 2166136261u ^ (seed * 0x9E3779B9u);
+    for (char ch : name) {
+        h ^= static_cast<unsigned char>(ch);
+        h *= 16777619u;
+    }
+    return h ^ (h >> 16);
+}
+
+constexpr bool IsPerfect(uint32_t seed)
+{
+    std::array<bool, kTableSize> used{};
+    for (size_t i = 1; i < kNames.size(); ++i) {
+        size_t slot = Hash(kNames[i], seed) & (kTableSize - 1);
+        if (used[slot]) {
+            return false;
+        }
+        used[slot] = true;
+    }
+    return true;
+}
+
+constexpr uint32_t FindSeed()
+{
+    for (uint32_t seed = 0; seed < 10000; ++seed) {
+        if (IsPerfect(seed)) {
+            return seed;
+        }
+    }
+    return UINT32_MAX;
+}
+
+constexpr uint32_t kSeed = FindSeed();
+static_assert(kSeed != UINT32_MAX, "no perfect hash seed found for the DAP message names, increase kTableSize");
+
+constexpr std::array<eMessageName, kTableSize> BuildTable()
+{
+    std::array<eMessageName, kTableSize> table{};
+    for (size_t i = 1; i < kNames.size(); ++i) {
+        table[Hash(kNames[i], kSeed) & (kTableSize - 1)] = static_cast<eMessageName>(i);
+    }
+    return table;
+}
+
+constexpr std::array<eMessageName, kTableSize> kTable = BuildTable();
+} // namespace message_names
+
+/**
+ * @brief return the id of a DAP command / event name, eMessageName::kUnknown if the name is not in the table
+ */
+constexpr eMessageName FindMessageName(std::string_view name)
+{
+    eMessageName id = message_names::kTable[message_names::Hash(name, message_names::kSeed) &
+                                            (message_names::kTableSize - 1)];
+    return message_names::kNames[static_cast<size_t>(id)] == name ? id : eMessageName::kUnknown;
+}
+
+/**
+ * @brief return the DAP name of `id`
+ */
+constexpr std::string_view GetMessageName(eMessageName id)
+{
+    return static_cast<size_t>(id) < message_names::kNames.size() ? message_names::kNames[static_cast<size_t>(id)]
+                                                                   : std::string_view{};
+}
+} // namespace dap
+#endif // DAP_MESSAGENAMES_HPP
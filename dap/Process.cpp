@@ -13,12 +13,29 @@ void dap::Process::StartThreads()
                 bool readSuccess = process->DoRead(stdoutBuff, stderrBuff);
                 bool readSomething = (!stdoutBuff.empty() || !stderrBuff.empty());
                 if (readSomething && readSuccess) {
-                    if (!stdoutBuff.empty()) {
-                        outq.push(stdoutBuff);
+                    // the transport always drains stdout: when it falls behind, sleep until it makes room. Cleanup()
+                    // closes the queue, which wakes us up
+                    if (!stdoutBuff.empty() && !outq.push(std::move(stdoutBuff))) {
+                        break;
                     }
                     if (!stderrBuff.empty()) {
-                        errq.push(stderrBuff);
+                        // stderr is only read along with stdout, nobody is guaranteed to drain it: never wait for
+                        // room, make some by dropping the oldest output instead
+                        size_t dropped = 0;
+                        std::string oldest;
+                        while (!errq.try_push(std::move(stderrBuff))) {
+                            if (errq.try_pop(oldest)) {
+                                ++dropped;
+                            }
+                        }
+                        if (dropped) {
+                            LOG_WARNING() << "Process stderr queue is full, dropped" << dropped << "chunk(s)" << endl;
+                        }
                     }
+                } else if (!process->IsAlive()) {
+                    // IsAlive() reaps the child, no need for a separate thread polling it
+                    LOG_ERROR() << "Process terminated. Exit code:" << process->GetExitCode() << endl;
+                    break;
                 } else {
                     std::this_thread::sleep_for(std::chrono::milliseconds(5));
                 }
@@ -26,34 +43,33 @@ void dap::Process::StartThreads()
             LOG_ERROR() << "Going down";
         },
         this, std::ref(m_stdoutQueue), std::ref(m_stderrQueue), std::ref(m_shutdown));
-
-    m_isAliveThread = new std::thread(
-        [](dap::Process* process, std::atomic_bool& shutdown) {
-            while (process->IsAlive() && !shutdown.load()) {
-                std::this_thread::sleep_for(std::chrono::milliseconds(10));
-            }
-            // if we reached here, we the process terminated, fire event, set the shutdown flag
-            // and exit
-            shutdown.store(true);
-            LOG_ERROR() << "Process terminated." << endl;
-        },
-        this, std::ref(m_shutdown));
 }
 
 dap::Process::~Process() {}
 
+bool dap::Process::WriteBatch(const std::string_view* buffers, size_t count)
+{
+    size_t total = 0;
+    for (size_t i = 0; i < count; ++i) {
+        total += buffers[i].size();
+    }
+    std::string joined;
+    joined.reserve(total);
+    for (size_t i = 0; i < count; ++i) {
+        joined.append(buffers[i]);
+    }
+    return Write(joined);
+}
+
 void dap::Process::Cleanup()
 {
     m_shutdown = true;
+    // the reader thread may be waiting for room in the stdout queue
+    m_stdoutQueue.close();
     if (m_readerThread) {
         m_readerThread->join();
     }
-
-    if (m_isAliveThread) {
-        m_isAliveThread->join();
-    }
     wxDELETE(m_readerThread);
-    wxDELETE(m_isAliveThread);
     m_shutdown = false;
 }
 
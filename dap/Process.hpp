@@ -5,6 +5,7 @@
 #include "dap_exports.hpp"
 
 #include <atomic>
+#include <string_view>
 #include <thread>
 #include <wx/event.h>
 #include <wx/process.h>
@@ -25,6 +26,12 @@ public:
 
     virtual bool Write(const std::string& str) = 0;
     virtual bool WriteLn(const std::string& str) = 0;
+
+    /**
+     * @brief write `count` buffers to the process stdin, back to back. The default implementation joins them and
+     * calls `Write()`
+     */
+    virtual bool WriteBatch(const std::string_view* buffers, size_t count);
     virtual bool IsAlive() const = 0;
     virtual void Terminate() = 0;
     virtual void Cleanup();
@@ -35,6 +42,25 @@ public:
     std::optional<std::string> ReadStdout(int timeout_ms);
     std::optional<std::string> ReadStderr(int timeout_ms);
 
+    /**
+     * @brief the read end of the child stdout / stderr pipes, for callers that poll them directly instead of using
+     * ReadStdout() / ReadStderr() (in which case the reader threads must not be started). -1 if not supported
+     */
+    virtual int GetStdoutFd() const { return -1; }
+    virtual int GetStderrFd() const { return -1; }
+
+    /**
+     * @brief a descriptor that becomes readable once the process has exited (a pidfd on Linux, a kqueue watching the
+     * process on macOS), so exit can be detected by the same poll() call that waits for the pipes. -1 if not supported
+     */
+    virtual int GetExitFd() const { return -1; }
+
+    /**
+     * @brief the process exit code, 128 + the signal number if it was killed by a signal. -1 while it is still running
+     * (or if the status could not be collected)
+     */
+    virtual int GetExitCode() const { return -1; }
+
 protected:
     /**
      * @brief implement the actual read call. This method is not accessible outside of this class
@@ -43,7 +69,6 @@ protected:
 
 private:
     std::thread* m_readerThread = nullptr;
-    std::thread* m_isAliveThread = nullptr;
     std::atomic_bool m_shutdown;
     int m_processId = wxNOT_FOUND;
     Queue<std::string> m_stdoutQueue;
@@ -54,10 +79,12 @@ private:
  * @brief Create process and return the handle to it
  * @param cmd process command
  * @param workingDir process's working directory
+ * @param startThreads start the threads feeding ReadStdout() / ReadStderr(). Pass false to poll the pipes returned by
+ * GetStdoutFd() / GetStderrFd() instead (ignored where those are not supported)
  * @return pointer to Process object
  */
 WXDLLIMPEXP_DAP Process* ExecuteProcess(const wxString& cmd, // Command Line
-                                        const wxString& workingDir = ".");
+                                        const wxString& workingDir = ".", bool startThreads = true);
 
 }; // namespace dap
 #endif // PROCESS_H__
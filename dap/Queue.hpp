@@ -1,45 +1,247 @@
 #ifndef QUEUE_HPP
 #define QUEUE_HPP
 
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
 #include <mutex>
 #include <optional>
 #include <vector>
 
 namespace dap
 {
+/// A bounded, lock-free queue (Vyukov's ring of sequenced cells). Any number of threads may push and pop, although
+/// the library uses it with a single consumer.
+///
+/// Items are moved in and out, never copied. Only a consumer waiting on an empty queue (or a producer waiting on a full
+/// one) takes a lock: the other side touches the mutex only when someone is known to be sleeping, so the uncontended
+/// path is a couple of atomic operations
 template <typename T>
 class Queue
 {
-    std::vector<T> Q;
-    std::mutex mutex_lock;
-    std::condition_variable cv;
+    struct Cell {
+        std::atomic<size_t> sequence;
+        std::optional<T> value;
+    };
+
+    std::unique_ptr<Cell[]> m_cells;
+    size_t m_mask = 0;
+    alignas(64) std::atomic<size_t> m_tail{ 0 }; // next position to push
+    alignas(64) std::atomic<size_t> m_head{ 0 }; // next position to pop
+    alignas(64) std::atomic<int> m_sleepers{ 0 };  // consumers waiting for an item
+    alignas(64) std::atomic<int> m_producers{ 0 }; // producers waiting for room
+    std::atomic_bool m_closed{ false };
+    std::mutex m_lock;
+    std::condition_variable m_cv;
+    std::condition_variable m_roomCv;
+
+    void WakeSleepers()
+    {
+        // pairs with the fence in pop(): either the consumer sees the new item or we see it sleeping
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (m_sleepers.load(std::memory_order_relaxed) > 0) {
+            std::lock_guard<std::mutex> locker(m_lock);
+            m_cv.notify_one();
+        }
+    }
+
+    void WakeProducers()
+    {
+        // pairs with the fence in push(): either the producer sees the free cell or we see it sleeping
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (m_producers.load(std::memory_order_relaxed) > 0) {
+            std::lock_guard<std::mutex> locker(m_lock);
+            m_roomCv.notify_one();
+        }
+    }
+
+    bool DoPush(T& o)
+    {
+        size_t pos = m_tail.load(std::memory_order_relaxed);
+        Cell* cell;
+        while (true) {
+            cell = &m_cells[pos & m_mask];
+            size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (m_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                // full
+                return false;
+            } else {
+                pos = m_tail.load(std::memory_order_relaxed);
+            }
+        }
+        cell->value.emplace(std::move(o));
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool DoPop(T& o)
+    {
+        size_t pos = m_head.load(std::memory_order_relaxed);
+        Cell* cell;
+        while (true) {
+            cell = &m_cells[pos & m_mask];
+            size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (m_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                // empty
+                return false;
+            } else {
+                pos = m_head.load(std::memory_order_relaxed);
+            }
+        }
+        o = std::move(*cell->value);
+        cell->value.reset();
+        cell->sequence.store(pos + m_mask + 1, std::memory_order_release);
+        return true;
+    }
 
 public:
-    bool empty() const { return Q.empty(); }
+    /**
+     * @param capacity maximum number of queued items, rounded up to a power of 2
+     */
+    explicit Queue(size_t capacity = 1024)
+    {
+        size_t size = 2;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        m_cells.reset(new Cell[size]);
+        m_mask = size - 1;
+        for (size_t i = 0; i < size; ++i) {
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    Queue(const Queue&) = delete;
+    Queue& operator=(const Queue&) = delete;
+
+    /**
+     * @brief push `o` if there is room for it. Never blocks
+     */
+    bool try_push(T&& o)
+    {
+        if (!DoPush(o)) {
+            return false;
+        }
+        WakeSleepers();
+        return true;
+    }
 
-    void push(T o)
+    /**
+     * @brief push `o`, sleeping until a pop() makes room while the queue is full. Return false (and drop `o`) if the
+     * queue is closed
+     */
+    bool push(T o)
     {
-        std::unique_lock<std::mutex> locker(mutex_lock);
-        Q.emplace_back(o);
-        cv.notify_all();
+        if (m_closed.load()) {
+            return false;
+        }
+        if (try_push(std::move(o))) {
+            return true;
+        }
+
+        bool pushed = false;
+        {
+            std::unique_lock<std::mutex> locker(m_lock);
+            m_producers.fetch_add(1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            m_roomCv.wait(locker, [&]() {
+                pushed = DoPush(o);
+                return pushed || m_closed.load();
+            });
+            m_producers.fetch_sub(1, std::memory_order_relaxed);
+        }
+        if (pushed) {
+            WakeSleepers();
+        }
+        return pushed;
     }
 
+    /**
+     * @brief move the oldest item into `o`. Return false if the queue is empty. Never blocks
+     */
+    bool try_pop(T& o)
+    {
+        if (!DoPop(o)) {
+            return false;
+        }
+        WakeProducers();
+        return true;
+    }
+
+    /**
+     * @brief pop the oldest item, waiting up to `ms` for one to arrive
+     */
     std::optional<T> pop(const std::chrono::milliseconds& ms)
     {
-        std::unique_lock<std::mutex> locker(mutex_lock);
-        if (cv.wait_for(locker, ms, [this]() { return !Q.empty(); })) {
-            if (Q.empty()) {
-                // spuriously wakeup?
-                return {};
-            }
-            // get the first item from the list
-            T o = (*Q.begin());
-            Q.erase(Q.begin());
+        T o;
+        if (try_pop(o)) {
+            return o;
+        }
+
+        bool popped = false;
+        {
+            std::unique_lock<std::mutex> locker(m_lock);
+            m_sleepers.fetch_add(1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            m_cv.wait_for(locker, ms, [&]() {
+                popped = DoPop(o);
+                return popped || m_closed.load();
+            });
+            m_sleepers.fetch_sub(1, std::memory_order_relaxed);
+        }
+        if (popped) {
+            WakeProducers();
             return o;
         }
         return {};
     }
+
+    /**
+     * @brief move every queued item to the end of `items`, return the number of items moved. Never blocks
+     */
+    size_t pop_all(std::vector<T>& items)
+    {
+        size_t count = 0;
+        T o;
+        while (try_pop(o)) {
+            items.push_back(std::move(o));
+            ++count;
+        }
+        return count;
+    }
+
+    /**
+     * @brief is the queue empty? (a snapshot, it may change as soon as it returns)
+     */
+    bool empty() const
+    {
+        size_t pos = m_head.load(std::memory_order_acquire);
+        return m_cells[pos & m_mask].sequence.load(std::memory_order_acquire) != pos + 1;
+    }
+
+    /**
+     * @brief make push() fail from now on and wake up everyone waiting. Items already queued can still be popped
+     */
+    void close()
+    {
+        m_closed.store(true);
+        std::lock_guard<std::mutex> locker(m_lock);
+        m_cv.notify_all();
+        m_roomCv.notify_all();
+    }
 };
 }; // namespace dap
-#endif // QUEUE_HPP
\ No newline at end of file
+#endif // QUEUE_HPP
@@ -0,0 +1,104 @@
+#ifndef DAP_SPSCQUEUE_HPP
+#define DAP_SPSCQUEUE_HPP
+
+#include <atomic>
+#include <optional>
+#include <utility>
+
+namespace dap
+{
+/// An unbounded, lock-free, single producer / single consumer queue.
+///
+/// `push()` must only be called from one thread and `pop()` from one (other) thread. Both are wait-free: the producer
+/// never blocks on the consumer and vice versa. Nodes released by the consumer are recycled by the producer, so once
+/// the queue reached its steady state size, pushing does not allocate
+template <typename T>
+class SPSCQueue
+{
+    struct Node {
+        std::atomic<Node*> next{ nullptr };
+        std::optional<T> value;
+    };
+
+    // consumer side: the last consumed node. Its `next` is the first node to pop
+    alignas(64) std::atomic<Node*> m_tail;
+
+    // producer side: the last pushed node, the oldest node (consumed nodes from m_first up to the consumer tail can be
+    // recycled) and a cached copy of the consumer tail
+    alignas(64) Node* m_head;
+    Node* m_first;
+    Node* m_tailCopy;
+
+    Node* AllocNode()
+    {
+        if (m_first == m_tailCopy) {
+            m_tailCopy = m_tail.load(std::memory_order_acquire);
+        }
+        if (m_first != m_tailCopy) {
+            Node* node = m_first;
+            m_first = m_first->next.load(std::memory_order_relaxed);
+            node->next.store(nullptr, std::memory_order_relaxed);
+            return node;
+        }
+        return new Node();
+    }
+
+public:
+    SPSCQueue()
+    {
+        Node* dummy = new Node();
+        m_tail.store(dummy, std::memory_order_relaxed);
+        m_head = m_first = m_tailCopy = dummy;
+    }
+
+    ~SPSCQueue()
+    {
+        Node* node = m_first;
+        while (node) {
+            Node* next = node->next.load(std::memory_order_relaxed);
+            delete node;
+            node = next;
+        }
+    }
+
+    SPSCQueue(const SPSCQueue&) = delete;
+    SPSCQueue& operator=(const SPSCQueue&) = delete;
+
+    /**
+     * @brief append `o` to the queue. Producer thread only
+     */
+    void push(T o)
+    {
+        Node* node = AllocNode();
+        node->value.emplace(std::move(o));
+        m_head->next.store(node, std::memory_order_release);
+        m_head = node;
+    }
+
+    /**
+     * @brief move the oldest item into `o`. Return false if the queue is empty. Consumer thread only
+     */
+    bool pop(T& o)
+    {
+        Node* tail = m_tail.load(std::memory_order_relaxed);
+        Node* next = tail->next.load(std::memory_order_acquire);
+        if (!next) {
+            return false;
+        }
+        o = std::move(*next->value);
+        next->value.reset();
+        // hand `tail` back to the producer for recycling, `next` becomes the new dummy node
+        m_tail.store(next, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief is the queue empty? Consumer thread only
+     */
+    bool empty() const
+    {
+        return m_tail.load(std::memory_order_relaxed)->next.load(std::memory_order_acquire) == nullptr;
+    }
+};
+} // namespace dap
+#endif // DAP_SPSCQUEUE_HPP
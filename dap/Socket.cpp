@@ -1,19 +1,31 @@
 #include "Socket.hpp"
 
 #include "Exception.hpp"
+#include "Interrupter.hpp"
 
 #include <cerrno>
+#include <chrono>
 #include <cstdio>
+#include <cstring>
 #include <memory>
 #include <sstream>
 
 #ifndef _WIN32
 #include <fcntl.h>
-#include <sys/select.h>
+#include <sys/ioctl.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <unistd.h>
 #endif
+namespace
+{
+/// read size used when the socket can't tell how much data is pending
+constexpr size_t kDefaultReadSize = 16 << 10;
+/// stop draining the socket after this many bytes so a fast sender can not starve the caller
+constexpr size_t kMaxReadPerCall = 8 << 20;
+} // namespace
+
 namespace dap
 {
 Socket::Socket(socket_t sockfd)
@@ -63,8 +75,52 @@ int Socket::Read(char* buffer, size_t bufferSize, size_t& bytesRead)
     return kSuccess;
 }
 
+int Socket::Read(ByteBuffer& buffer, size_t& bytesRead)
+{
+    bytesRead = 0;
+    while (bytesRead < kMaxReadPerCall) {
+        // ask the kernel how much is pending so a large message is received with a single recv()
+        size_t pending = 0;
+#ifdef _WIN32
+        u_long count = 0;
+        if (::ioctlsocket(m_socket, FIONREAD, &count) == 0) {
+            pending = count;
+        }
+#else
+        int count = 0;
+        if (::ioctl(m_socket, FIONREAD, &count) == 0 && count > 0) {
+            pending = static_cast<size_t>(count);
+        }
+#endif
+        char* dest = buffer.PrepareWrite(pending > kDefaultReadSize ? pending : kDefaultReadSize);
+        size_t room = buffer.WritableBytes();
+        int res = recv(m_socket, dest, room, 0);
+        if (res < 0) {
+            int err = GetLastError();
+            if (eWouldBlock == err) {
+                break;
+            }
+            throw Exception("Read failed: " + error(err));
+        } else if (0 == res) {
+            if (bytesRead) {
+                // return what we have, the next read will report the closed connection
+                break;
+            }
+            throw Exception("Read failed: " + error());
+        }
+
+        buffer.Commit(static_cast<size_t>(res));
+        bytesRead += static_cast<size_t>(res);
+        if (static_cast<size_t>(res) < room) {
+            // short read: the socket is drained
+            break;
+        }
+    }
+    return bytesRead ? kSuccess : kTimeout;
+}
+
 // Send API
-void Socket::Send(const std::string& msg)
+void Socket::Send(std::string_view msg)
 {
     if (m_socket == INVALID_SOCKET) {
         throw Exception("Invalid socket!");
@@ -86,6 +142,179 @@ void Socket::Send(const std::string& msg)
     }
 }
 
+size_t Socket::SendSome(const std::string_view* buffers, size_t count)
+{
+    if (m_socket == INVALID_SOCKET) {
+        throw Exception("Invalid socket!");
+    }
+    if (count > kMaxSendBuffers) {
+        count = kMaxSendBuffers;
+    }
+    if (count == 0) {
+        return 0;
+    }
+
+#ifdef _WIN32
+    WSABUF wsabufs[kMaxSendBuffers];
+    for (size_t i = 0; i < count; ++i) {
+        wsabufs[i].buf = const_cast<char*>(buffers[i].data());
+        wsabufs[i].len = static_cast<ULONG>(buffers[i].length());
+    }
+    DWORD bytesSent = 0;
+    if (::WSASend(m_socket, wsabufs, static_cast<DWORD>(count), &bytesSent, 0, nullptr, nullptr) != 0) {
+        int err = GetLastError();
+        if (err == eWouldBlock) {
+            return 0;
+        }
+        throw Exception("Send failed: " + error(err));
+    }
+    return bytesSent;
+#else
+    return SendSome(buffers, count, {});
+#endif
+}
+
+#ifndef _WIN32
+size_t Socket::SendSome(const std::string_view* buffers, size_t count, const std::vector<int>& fds)
+{
+    if (m_socket == INVALID_SOCKET) {
+        throw Exception("Invalid socket!");
+    }
+    if (count > kMaxSendBuffers) {
+        count = kMaxSendBuffers;
+    }
+    if (count == 0 || fds.size() > kMaxDescriptors) {
+        return 0;
+    }
+
+    iovec iov[kMaxSendBuffers];
+    for (size_t i = 0; i < count; ++i) {
+        iov[i].iov_base = const_cast<char*>(buffers[i].data());
+        iov[i].iov_len = buffers[i].length();
+    }
+    msghdr msg = {};
+    msg.msg_iov = iov;
+    msg.msg_iovlen = count;
+    union {
+        char buffer[CMSG_SPACE(sizeof(int) * kMaxDescriptors)];
+        cmsghdr align;
+    } control;
+    if (!fds.empty()) {
+        // the descriptors travel with the first byte written
+        msg.msg_control = control.buffer;
+        msg.msg_controllen = CMSG_SPACE(sizeof(int) * fds.size());
+        cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int) * fds.size());
+        std::memcpy(CMSG_DATA(cmsg), fds.data(), sizeof(int) * fds.size());
+    }
+    // never block, even on a blocking socket, and report a closed peer as an error instead of raising SIGPIPE
+#ifdef MSG_NOSIGNAL
+    const int flags = MSG_DONTWAIT | MSG_NOSIGNAL;
+#else
+    const int flags = MSG_DONTWAIT;
+#endif
+    while (true) {
+        ssize_t res = ::sendmsg(m_socket, &msg, flags);
+        if (res >= 0) {
+            return static_cast<size_t>(res);
+        }
+        int err = GetLastError();
+        if (err == EINTR) {
+            continue;
+        }
+        if (err == eWouldBlock || err == EAGAIN) {
+            return 0;
+        }
+        throw Exception("Send failed: " + error(err));
+    }
+}
+
+void Socket::SendWithDescriptors(std::string_view msg, const std::vector<int>& fds, long milliSeconds)
+{
+    if (m_socket == INVALID_SOCKET) {
+        throw Exception("Invalid socket!");
+    }
+    if (msg.empty() || fds.size() > kMaxDescriptors) {
+        throw Exception("SendWithDescriptors: invalid arguments");
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(milliSeconds);
+    bool descriptors_sent = false;
+    while (!msg.empty()) {
+        size_t sent = SendSome(&msg, 1, descriptors_sent ? std::vector<int>{} : fds);
+        if (sent) {
+            descriptors_sent = true;
+            msg.remove_prefix(sent);
+            continue;
+        }
+        auto left =
+            std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+        if (left <= 0 || SelectWriteMS(left) == kTimeout) {
+            throw Exception("SendWithDescriptors: timed out");
+        }
+    }
+}
+
+int Socket::ReadWithDescriptors(std::string& content, std::vector<int>& fds)
+{
+    char buffer[16 << 10];
+    iovec iov;
+    iov.iov_base = buffer;
+    iov.iov_len = sizeof(buffer);
+    union {
+        char buffer[CMSG_SPACE(sizeof(int) * kMaxDescriptors)];
+        cmsghdr align;
+    } control;
+    msghdr header = {};
+    header.msg_iov = &iov;
+    header.msg_iovlen = 1;
+    header.msg_control = control.buffer;
+    header.msg_controllen = sizeof(control.buffer);
+
+#ifdef MSG_CMSG_CLOEXEC
+    const int flags = MSG_CMSG_CLOEXEC;
+#else
+    const int flags = 0;
+#endif
+    ssize_t res = ::recvmsg(m_socket, &header, flags);
+    if (res < 0) {
+        int err = GetLastError();
+        if (eWouldBlock == err) {
+            return kTimeout;
+        }
+        throw Exception("Read failed: " + error(err));
+    } else if (0 == res) {
+        throw Exception("Read failed: " + error());
+    }
+
+    std::vector<int> received;
+    for (cmsghdr* cmsg = CMSG_FIRSTHDR(&header); cmsg; cmsg = CMSG_NXTHDR(&header, cmsg)) {
+        if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) {
+            continue;
+        }
+        size_t count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        const unsigned char* data = CMSG_DATA(cmsg);
+        for (size_t i = 0; i < count; ++i) {
+            int fd;
+            std::memcpy(&fd, data + i * sizeof(int), sizeof(int));
+            received.push_back(fd);
+        }
+    }
+    if (header.msg_flags & MSG_CTRUNC) {
+        // more descriptors than we have room for: the others are lost, don't pretend the message arrived whole
+        for (int fd : received) {
+            ::close(fd);
+        }
+        throw Exception("Read failed: too many descriptors received");
+    }
+    fds.insert(fds.end(), received.begin(), received.end());
+    content.assign(buffer, static_cast<size_t>(res));
+    return kSuccess;
+}
+#endif
+
 int Socket::GetLastError()
 {
 #ifdef _WIN32
@@ -162,6 +391,28 @@ void Socket::MakeSocketBlocking(bool blocking)
 #endif
 }
 
+int Socket::Poll(pollfd* fds, size_t count, long milliSeconds)
+{
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(milliSeconds < 0 ? 0 : milliSeconds);
+    int timeout = milliSeconds < 0 ? -1 : static_cast<int>(milliSeconds);
+    while (true) {
+#ifdef _WIN32
+        int rc = ::WSAPoll(fds, static_cast<ULONG>(count), timeout);
+#else
+        int rc = ::poll(fds, static_cast<nfds_t>(count), timeout);
+        if (rc < 0 && errno == EINTR) {
+            if (timeout > 0) {
+                auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline -
+                                                                                  std::chrono::steady_clock::now());
+                timeout = left.count() > 0 ? static_cast<int>(left.count()) : 0;
+            }
+            continue;
+        }
+#endif
+        return rc;
+    }
+}
+
 int Socket::SelectWriteMS(long milliSeconds)
 {
     if (milliSeconds < 0) {
@@ -171,16 +422,10 @@ int Socket::SelectWriteMS(long milliSeconds)
     if (m_socket == INVALID_SOCKET) {
         throw Exception("Invalid socket!");
     }
-#ifdef __WXMAC__
-    struct timeval tv = { milliSeconds / 1000, ((int)milliSeconds % 1000) * 1000 };
-#else
-    struct timeval tv = { milliSeconds / 1000, (milliSeconds % 1000) * 1000 };
-#endif
-    fd_set write_set;
-    FD_ZERO(&write_set);
-    FD_SET(m_socket, &write_set);
-    errno = 0;
-    int rc = select(m_socket + 1, NULL, &write_set, NULL, &tv);
+    pollfd fd = {};
+    fd.fd = m_socket;
+    fd.events = POLLOUT;
+    int rc = Poll(&fd, 1, milliSeconds);
     if (rc == 0) {
         // timeout
         return kTimeout;
@@ -190,7 +435,7 @@ int Socket::SelectWriteMS(long milliSeconds)
         throw Exception("SelectWriteMS failed: " + error());
 
     } else {
-        // we got something to read
+        // we can write (or the socket is in error, which the write will report)
         return kSuccess;
     }
 }
@@ -204,14 +449,10 @@ int Socket::SelectReadMS(long milliSeconds)
     if (m_socket == INVALID_SOCKET) {
         throw Exception("Invalid socket!");
     }
-    int seconds = milliSeconds / 1000; // convert the number into seconds
-    int ms = milliSeconds % 1000;      // the remainder is less than a second
-    struct timeval tv = { seconds, ms * 1000 };
-
-    fd_set readfds;
-    FD_ZERO(&readfds);
-    FD_SET(m_socket, &readfds);
-    int rc = select(m_socket + 1, &readfds, NULL, NULL, &tv);
+    pollfd fd = {};
+    fd.fd = m_socket;
+    fd.events = POLLIN;
+    int rc = Poll(&fd, 1, milliSeconds);
     if (rc == 0) {
         // timeout
         return kTimeout;
@@ -225,4 +466,28 @@ int Socket::SelectReadMS(long milliSeconds)
         return kSuccess;
     }
 }
-}; // namespace dap
\ No newline at end of file
+
+int Socket::SelectReadMS(long milliSeconds, const Interrupter& interrupter)
+{
+    if (m_socket == INVALID_SOCKET) {
+        throw Exception("Invalid socket!");
+    }
+
+    pollfd fds[2] = {};
+    fds[0].fd = m_socket;
+    fds[0].events = POLLIN;
+    fds[1].fd = interrupter.GetHandle();
+    fds[1].events = POLLIN;
+    int rc = Poll(fds, 2, milliSeconds);
+    if (rc == 0) {
+        return kTimeout;
+    } else if (rc < 0) {
+        throw Exception("SelectRead failed: " + error());
+    } else if (fds[1].revents) {
+        return kInterrupted;
+    } else {
+        // readable, hung up or in error: let the read report it
+        return kSuccess;
+    }
+}
+}; // namespace dap
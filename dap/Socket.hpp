@@ -1,9 +1,11 @@
 #ifndef DAP_SOCKET_H
 #define DAP_SOCKET_H
 
+#include "ByteBuffer.hpp"
 #include "dap_exports.hpp"
 
 #include <memory>
+#include <vector>
 #include <wx/string.h>
 #if defined(__WXOSX__) || defined(BSD)
 #include <sys/errno.h>
@@ -11,6 +13,8 @@
 
 #ifdef _WIN32
 #include <winsock2.h>
+#else
+#include <poll.h>
 #endif
 
 #ifdef _WIN32
@@ -24,6 +28,7 @@ typedef int socket_t;
 using namespace std;
 namespace dap
 {
+class Interrupter;
 class WXDLLIMPEXP_DAP Socket
 {
 protected:
@@ -36,6 +41,7 @@ public:
     enum {
         kSuccess = 1,
         kTimeout = 2,
+        kInterrupted = 3,
     };
 
 #ifdef _WIN32
@@ -45,6 +51,14 @@ public:
 #endif
 
     static int GetLastError();
+
+    /**
+     * @brief portable poll(): wait until one of `fds` is ready. Unlike select() there is no limit on the descriptor
+     * values. Interrupted calls are resumed with the remaining time
+     * @param milliSeconds number of _milliseconds_ to wait, a negative value waits forever
+     * @return the number of ready descriptors, 0 on timeout, -1 on error (see GetLastError())
+     */
+    static int Poll(pollfd* fds, size_t count, long milliSeconds);
     static wxString error();
     static wxString error(const int errorCode);
 
@@ -79,7 +93,46 @@ public:
      * @brief send message. This function blocks until the entire buffer is sent
      * @throws SocketException
      */
-    void Send(const std::string& msg);
+    void Send(std::string_view msg);
+
+#ifndef _WIN32
+    /// maximum number of descriptors passed with a single message
+    static constexpr size_t kMaxDescriptors = 16;
+
+    /**
+     * @brief send `msg` (must not be empty) along with the descriptors `fds` (SCM_RIGHTS). Unix domain sockets only.
+     * Waits up to `milliSeconds` for the socket to accept the entire buffer. A client transport should use
+     * SocketTransport::SendWithDescriptors() instead, which goes through its send queue and never blocks
+     * @throws SocketException on error or timeout
+     */
+    void SendWithDescriptors(std::string_view msg, const std::vector<int>& fds, long milliSeconds = 5000);
+
+    /**
+     * @brief same as SendSome(const std::string_view*, size_t), passing `fds` (SCM_RIGHTS) with the first byte
+     * written. The descriptors are sent only if the return value is not 0
+     * @throws SocketException
+     */
+    size_t SendSome(const std::string_view* buffers, size_t count, const std::vector<int>& fds);
+
+    /**
+     * @brief same as Read(std::string&), also collecting the descriptors received with the data into `fds`. The
+     * received descriptors are owned by the caller
+     * @return kSuccess or kTimeout
+     * @throws SocketException, also when more than kMaxDescriptors descriptors arrived (those received are closed)
+     */
+    int ReadWithDescriptors(std::string& content, std::vector<int>& fds);
+#endif
+
+    /// maximum number of buffers written by a single SendSome() call
+    static constexpr size_t kMaxSendBuffers = 64;
+
+    /**
+     * @brief gather-write as much of `buffers` (in order) as the socket accepts without blocking. Only the first
+     * kMaxSendBuffers buffers are considered
+     * @return number of bytes written, 0 if the socket send buffer is full
+     * @throws SocketException
+     */
+    size_t SendSome(const std::string_view* buffers, size_t count);
 
     /**
      * @brief
@@ -97,6 +150,15 @@ public:
      */
     int Read(std::string& content);
 
+    /**
+     * @brief read everything available on the socket straight into the free tail of `buffer`, growing it as needed
+     * (sized from the FIONREAD hint). Drains the socket in a single call, up to a few MB
+     * @param bytesRead [output] number of bytes appended to `buffer`
+     * @return kSuccess or kTimeout (nothing to read)
+     * @throws SocketException
+     */
+    int Read(ByteBuffer& buffer, size_t& bytesRead);
+
     /**
      * @brief select for read. Same as above, but use milli seconds instead
      * @param milliSeconds number of _milliseconds_ to wait
@@ -105,6 +167,14 @@ public:
      */
     int SelectReadMS(long milliSeconds);
 
+    /**
+     * @brief wait until the socket is readable or `interrupter` is signalled
+     * @param milliSeconds number of _milliseconds_ to wait, a negative value waits forever
+     * @return kSuccess, kTimeout or kInterrupted (the interrupter is left signalled)
+     * @throws SocketException
+     */
+    int SelectReadMS(long milliSeconds, const Interrupter& interrupter);
+
     /**
      * @brief select for write (milli seconds version)
      * @return kSuccess or kTimeout
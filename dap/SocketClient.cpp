@@ -9,6 +9,7 @@
 #include <netinet/in.h>
 #include <netinet/ip.h> /* superset of previous */
 #include <sys/socket.h>
+#include <cstring>
 #include <sys/un.h>
 #include <unistd.h>
 #endif
@@ -51,6 +52,35 @@ bool SocketClient::ConnectRemote(const wxString& address, int port)
     return rc == 0;
 }
 
+bool SocketClient::ConnectLocal(const wxString& socketPath)
+{
+#ifdef _WIN32
+    wxUnusedVar(socketPath);
+    return false;
+#else
+    DestroySocket();
+    struct sockaddr_un server;
+    auto path = socketPath.mb_str(wxConvUTF8);
+    if(path.length() >= sizeof(server.sun_path)) {
+        return false;
+    }
+
+    m_socket = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if(m_socket == INVALID_SOCKET) {
+        return false;
+    }
+    server.sun_family = AF_UNIX;
+    strcpy(server.sun_path, path.data());
+
+    RESET_ERRNO();
+    int rc = ::connect(m_socket, (struct sockaddr*)&server, sizeof(server));
+    if(rc == 0) {
+        MakeSocketBlocking(false);
+    }
+    return rc == 0;
+#endif
+}
+
 bool SocketClient::Connect(const wxString& connectionString)
 {
     ConnectionString cs(connectionString);
@@ -58,7 +88,7 @@ bool SocketClient::Connect(const wxString& connectionString)
         return false;
     }
     if(cs.GetProtocol() == ConnectionString::kUnixLocalSocket) {
-        throw Exception("Unsupported protocol");
+        return ConnectLocal(cs.GetPath());
     } else {
         // TCP
         return ConnectRemote(cs.GetHost(), cs.GetPort());
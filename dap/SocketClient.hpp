@@ -24,9 +24,14 @@ public:
      */
     bool ConnectRemote(const wxString& address, int port);
 
+    /**
+     * @brief connect to a Unix domain socket bound at `socketPath`. Not supported on Windows
+     */
+    bool ConnectLocal(const wxString& socketPath);
+
     /**
      * @brief connect using connection wxString
-     * @param connectionString in the format of tcp://127.0.0.1:1234
+     * @param connectionString in the format of tcp://127.0.0.1:1234 or unix:///path/to/socket
      * @return
      */
     bool Connect(const wxString& connectionString);
@@ -5,7 +5,9 @@
 
 #ifndef _WIN32
 #include <arpa/inet.h>
+#include <cerrno>
 #include <netinet/in.h>
+#include <cstring>
 #include <stdio.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
@@ -18,7 +20,56 @@ namespace dap
 {
 SocketServer::SocketServer() {}
 
-SocketServer::~SocketServer() { DestroySocket(); }
+SocketServer::~SocketServer()
+{
+    DestroySocket();
+#ifndef _WIN32
+    if(!m_localPath.empty()) {
+        ::unlink(m_localPath.mb_str(wxConvUTF8).data());
+    }
+#endif
+}
+
+void SocketServer::CreateLocalServer(const wxString& socketPath)
+{
+#ifdef _WIN32
+    wxUnusedVar(socketPath);
+    throw Exception("Unsupported protocol");
+#else
+    struct sockaddr_un server;
+    memset(&server, 0, sizeof(server));
+    auto path = socketPath.mb_str(wxConvUTF8);
+    if(path.length() >= sizeof(server.sun_path)) {
+        throw Exception("CreateServer: socket path is too long: " + socketPath);
+    }
+
+    // a stale socket file left by a previous run would make bind() fail. Remove it, but never anything else that
+    // happens to live at this path
+    struct stat st;
+    if(::lstat(path.data(), &st) == 0) {
+        if(!S_ISSOCK(st.st_mode)) {
+            errno = EADDRINUSE;
+            throw Exception("CreateServer: path exists and is not a socket: " + socketPath);
+        }
+        ::unlink(path.data());
+    }
+
+    if((m_socket = ::socket(AF_UNIX, SOCK_STREAM, 0)) == INVALID_SOCKET) {
+        throw Exception("Could not create socket: " + error());
+    }
+
+    server.sun_family = AF_UNIX;
+    strcpy(server.sun_path, path.data());
+    if(::bind(m_socket, (struct sockaddr*)&server, sizeof(server)) != 0) {
+        throw Exception("CreateServer: bind() error: " + error());
+    }
+    m_localPath = socketPath;
+
+    if(::listen(m_socket, 10) != 0) {
+        throw Exception("CreateServer: listen() error: " + error());
+    }
+#endif
+}
 
 int SocketServer::CreateServer(const wxString& address, int port)
 {
@@ -79,7 +130,8 @@ int SocketServer::Start(const wxString& connectionString)
     if(cs.GetProtocol() == ConnectionString::kTcp) {
         return CreateServer(cs.GetHost(), cs.GetPort());
     } else {
-        throw Exception("Unsupported protocol");
+        CreateLocalServer(cs.GetPath());
+        return 0;
     }
 }
 
@@ -11,6 +11,9 @@ namespace dap
 {
 class WXDLLIMPEXP_DAP SocketServer : public Socket
 {
+    /// the path of the Unix domain socket we created, removed on destruction
+    wxString m_localPath;
+
 public:
     SocketServer();
     virtual ~SocketServer();
@@ -22,10 +25,16 @@ protected:
      */
     int CreateServer(const wxString& address, int port);
 
+    /**
+     * @brief create a Unix domain socket server bound at `socketPath` (an existing socket file is replaced)
+     * @throw clSocketException
+     */
+    void CreateLocalServer(const wxString& socketPath);
+
 public:
     /**
-     * @brief Create server using connection string
-     * @return port number on success
+     * @brief Create server using connection string (tcp://127.0.0.1:1234 or unix:///path/to/socket)
+     * @return port number on success, 0 for a Unix domain socket
      * @throw clSocketException
      */
     int Start(const wxString& connectionString);
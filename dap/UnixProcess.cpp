@@ -2,12 +2,35 @@
 
 #if defined(__APPLE__) || defined(__linux__)
 #include "Log.hpp"
+#include "Socket.hpp"
 
 #include <csignal>
 #include <cstring>
-#include <sys/select.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <spawn.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <wx/string.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#else
+#include <crt_externs.h>
+#include <sys/event.h>
+#endif
+
+// posix_spawn can be used when it is able to close the inherited descriptors (glibc 2.34+, macOS)
+#if defined(__APPLE__)
+#define DAP_HAVE_SPAWN_CLOSEFROM 1
+#elif defined(__GLIBC__)
+#if __GLIBC_PREREQ(2, 34)
+#define DAP_HAVE_SPAWN_CLOSEFROM 1
+#endif
+#endif
+
+#ifndef DAP_HAVE_SPAWN_CLOSEFROM
+#define DAP_HAVE_SPAWN_CLOSEFROM 0
+#endif
 
 UnixProcess::UnixProcess(const vector<wxString>& args)
 {
@@ -19,53 +42,246 @@ UnixProcess::UnixProcess(const vector<wxString>& args)
         return;
     }
 
-    child_pid = fork();
+    if (args.empty()) {
+        LOG_ERROR() << "Failed to start child process: empty command";
+        return;
+    }
+
+    // build argv in the parent: nothing may allocate between fork and exec
+    std::vector<std::string> argStorage;
+    argStorage.reserve(args.size());
+    for (const wxString& arg : args) {
+        argStorage.emplace_back(arg.mb_str().data());
+    }
+    std::vector<char*> argv;
+    argv.reserve(args.size() + 1);
+    for (std::string& arg : argStorage) {
+        argv.push_back(&arg[0]);
+    }
+    argv.push_back(nullptr);
+
+    child_pid = Spawn(argv.data());
     if (child_pid == -1) {
-        LOG_ERROR() << "Failed to start child process" << strerror(errno);
+        LOG_ERROR() << "Failed to start child process:" << args << strerror(errno);
+    }
+
+    // parent process
+    m_childStdin.CloseReadFd();
+    m_childStdout.CloseWriteFd();
+    m_childStderr.CloseWriteFd();
+    if (child_pid != -1) {
+        OpenExitFd();
+        // Write() must never block on a full pipe: it waits for room itself, so that it can give up on shutdown
+        int fd = m_childStdin.GetWriteFd();
+        ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
     }
-    if (child_pid == 0) {
-        // In child process
+}
+
+pid_t UnixProcess::Spawn(char* const* argv)
+{
+#if DAP_HAVE_SPAWN_CLOSEFROM
+    // posix_spawn uses vfork (or clone(CLONE_VFORK)): no copy of the parent address space, and a failing exec is
+    // reported here instead of by a child that exits right away
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, m_childStdin.GetReadFd(), STDIN_FILENO);
+    posix_spawn_file_actions_adddup2(&actions, m_childStdout.GetWriteFd(), STDOUT_FILENO);
+    posix_spawn_file_actions_adddup2(&actions, m_childStderr.GetWriteFd(), STDERR_FILENO);
+
+    posix_spawnattr_t attr;
+    posix_spawnattr_init(&attr);
+    sigset_t mask;
+    sigemptyset(&mask);
+    posix_spawnattr_setsigmask(&attr, &mask);
+    short flags = POSIX_SPAWN_SETSIGMASK;
+
+    // prevent descriptor leak into child process
+#ifdef __APPLE__
+    flags |= POSIX_SPAWN_CLOEXEC_DEFAULT;
+    char** envp = *_NSGetEnviron();
+#else
+    posix_spawn_file_actions_addclosefrom_np(&actions, 3);
+    char** envp = environ;
+#endif
+    posix_spawnattr_setflags(&attr, flags);
+
+    pid_t pid = -1;
+    int rc = posix_spawnp(&pid, argv[0], &actions, &attr, argv, envp);
+    posix_spawnattr_destroy(&attr);
+    posix_spawn_file_actions_destroy(&actions);
+    if (rc != 0) {
+        errno = rc;
+        return -1;
+    }
+    return pid;
+#else
+    pid_t pid = fork();
+    if (pid == 0) {
+        // In child process. The pipes are close-on-exec, dup2 clears the flag on the copies
         dup2(m_childStdin.GetReadFd(), STDIN_FILENO);
         dup2(m_childStdout.GetWriteFd(), STDOUT_FILENO);
         dup2(m_childStderr.GetWriteFd(), STDERR_FILENO);
-        m_childStdin.Close();
-        m_childStdout.Close();
-        m_childStderr.Close();
 
         // prevent descriptor leak into child process
-        const int fd_max = (sysconf(_SC_OPEN_MAX) != -1 ? sysconf(_SC_OPEN_MAX) : FD_SETSIZE);
-        for (int fd = 3; fd < fd_max; fd++) {
-            close(fd);
+#ifdef SYS_close_range
+        if (::syscall(SYS_close_range, 3, ~0U, 0) != 0)
+#endif
+        {
+            const int fd_max = (sysconf(_SC_OPEN_MAX) != -1 ? sysconf(_SC_OPEN_MAX) : FD_SETSIZE);
+            for (int fd = 3; fd < fd_max; fd++) {
+                close(fd);
+            }
         }
+        execvp(argv[0], argv);
+        // Note: no point writing to stdout here, it has been redirected
+        _exit(127);
+    }
+    return pid;
+#endif
+}
 
-        char** argv = new char*[args.size() + 1];
-        for (size_t i = 0; i < args.size(); ++i) {
-            const wxString& arg = args[i];
-            argv[i] = new char[arg.length() + 1];
-            strcpy(argv[i], arg.c_str());
-            argv[i][arg.length()] = 0;
-        }
-        argv[args.size()] = 0;
-        int result = execvp(argv[0], const_cast<char* const*>(argv));
-        int errNo = errno;
-        if (result == -1) {
-            // Note: no point writing to stdout here, it has been redirected
-            LOG_ERROR() << "Error: Failed to launch program:" << args;
-            exit(EXIT_FAILURE);
+namespace
+{
+/// blocks SIGPIPE for the calling thread while in scope, so a write to a pipe whose reader went away fails with EPIPE
+/// instead of killing the host application. A SIGPIPE raised meanwhile is discarded, one pending before is kept
+class SigpipeGuard
+{
+    sigset_t m_pipeMask;
+    sigset_t m_oldMask;
+    bool m_wasPending = false;
+
+    static bool IsPending()
+    {
+        sigset_t pending;
+        sigemptyset(&pending);
+        return ::sigpending(&pending) == 0 && sigismember(&pending, SIGPIPE) == 1;
+    }
+
+public:
+    SigpipeGuard()
+    {
+        sigemptyset(&m_pipeMask);
+        sigaddset(&m_pipeMask, SIGPIPE);
+        ::pthread_sigmask(SIG_BLOCK, &m_pipeMask, &m_oldMask);
+        m_wasPending = IsPending();
+    }
+
+    ~SigpipeGuard()
+    {
+        if (!m_wasPending && IsPending()) {
+            int signal = 0;
+            ::sigwait(&m_pipeMask, &signal);
         }
-    } else {
-        // parent process
-        m_childStdin.CloseReadFd();
-        m_childStdout.CloseWriteFd();
-        m_childStderr.CloseWriteFd();
+        ::pthread_sigmask(SIG_SETMASK, &m_oldMask, nullptr);
     }
+};
+
+/// give a child process that did not exit on SIGTERM a grace period, then kill it, and reap it. On a detached thread:
+/// this must not hold up the thread deleting the process (usually the UI thread). Takes ownership of `exitFd`
+void ReapInBackground(pid_t pid, int exitFd)
+{
+    std::thread([pid, exitFd]() {
+        constexpr long kGracePeriodMs = 1000;
+        bool exited = false;
+        if (exitFd != -1) {
+            pollfd pfd = {};
+            pfd.fd = exitFd;
+            pfd.events = POLLIN;
+            exited = dap::Socket::Poll(&pfd, 1, kGracePeriodMs) > 0;
+            ::close(exitFd);
+        } else {
+            for (long waited = 0; waited < kGracePeriodMs; waited += 10) {
+                if (::waitpid(pid, nullptr, WNOHANG) != 0) {
+                    // reaped (or not our child anymore)
+                    return;
+                }
+                this_thread::sleep_for(chrono::milliseconds(10));
+            }
+        }
+        if (!exited) {
+            ::kill(pid, SIGKILL);
+        }
+        while (::waitpid(pid, nullptr, 0) == -1 && errno == EINTR) {
+        }
+    }).detach();
 }
+} // namespace
 
 UnixProcess::~UnixProcess()
 {
-    // Kill the child process (if it is still alive)
+    // ask the child process to exit (if it is still alive)
     Terminate();
     Process::Cleanup();
+    if (IsAlive()) {
+        ReapInBackground(child_pid, m_exitFd);
+        m_exitFd = -1;
+    }
+    CLOSE_FD(m_exitFd);
+}
+
+void UnixProcess::OpenExitFd()
+{
+#if defined(__linux__) && defined(SYS_pidfd_open)
+    // a pidfd is close-on-exec and becomes readable when the process exits. Not available before Linux 5.3
+    m_exitFd = ::syscall(SYS_pidfd_open, child_pid, 0);
+    if (m_exitFd == -1) {
+        LOG_DEBUG() << "pidfd_open failed:" << strerror(errno);
+    }
+#elif defined(__APPLE__)
+    // a kqueue becomes readable when it has a pending event: register for the process exit
+    int kq = ::kqueue();
+    if (kq == -1) {
+        LOG_DEBUG() << "kqueue failed:" << strerror(errno);
+        return;
+    }
+    struct kevent ev;
+    EV_SET(&ev, child_pid, EVFILT_PROC, EV_ADD, NOTE_EXIT, 0, nullptr);
+    if (::kevent(kq, &ev, 1, nullptr, 0, nullptr) == -1) {
+        LOG_DEBUG() << "kevent(EVFILT_PROC) failed:" << strerror(errno);
+        ::close(kq);
+        return;
+    }
+    ::fcntl(kq, F_SETFD, FD_CLOEXEC);
+    m_exitFd = kq;
+#endif
+}
+
+bool UnixProcess::Reap() const
+{
+    std::lock_guard<std::mutex> locker(m_reapLock);
+    if (m_reaped || child_pid == -1) {
+        return true;
+    }
+
+    int status = 0;
+    pid_t rc;
+    do {
+        rc = ::waitpid(child_pid, &status, WNOHANG);
+    } while (rc == -1 && errno == EINTR);
+
+    if (rc == 0) {
+        // still running
+        return false;
+    }
+
+    if (rc == child_pid) {
+        if (WIFEXITED(status)) {
+            m_exitCode = WEXITSTATUS(status);
+        } else if (WIFSIGNALED(status)) {
+            m_exitCode = 128 + WTERMSIG(status);
+        }
+    } else {
+        // ECHILD: someone else reaped it (e.g. SIGCHLD is ignored), the status is lost
+        LOG_DEBUG() << "waitpid failed:" << strerror(errno);
+    }
+    m_reaped = true;
+    return true;
+}
+
+int UnixProcess::GetExitCode() const
+{
+    std::lock_guard<std::mutex> locker(m_reapLock);
+    return m_reaped ? m_exitCode : -1;
 }
 
 #define CHUNK_SIZE 1024
@@ -73,30 +289,23 @@ UnixProcess::~UnixProcess()
 
 bool UnixProcess::ReadAll(int fd, std::string& content, int timeoutMilliseconds)
 {
-    fd_set rset;
     char buff[CHUNK_SIZE];
-    FD_ZERO(&rset);
-    FD_SET(fd, &rset);
-
-    int seconds = timeoutMilliseconds / 1000;
-    int ms = timeoutMilliseconds % 1000;
+    pollfd pfd = {};
+    pfd.fd = fd;
+    pfd.events = POLLIN;
 
-    struct timeval tv = { seconds, ms * 1000 }; //  10 milliseconds timeout
+    long timeout = timeoutMilliseconds;
     while (true) {
-        int rc = ::select(fd + 1, &rset, nullptr, nullptr, &tv);
+        int rc = dap::Socket::Poll(&pfd, 1, timeout);
         if (rc > 0) {
             int len = read(fd, buff, (sizeof(buff) - 1));
             if (len > 0) {
-                buff[len] = 0;
-                content.append(buff);
+                content.append(buff, len);
                 if (content.length() >= MAX_BUFF_SIZE) {
                     return true;
                 }
-                // clear the tv struct so next select() call will return immediately
-                tv.tv_usec = 0;
-                tv.tv_sec = 0;
-                FD_ZERO(&rset);
-                FD_SET(fd, &rset);
+                // clear the timeout so next poll() call will return immediately
+                timeout = 0;
                 continue;
             }
         } else if (rc == 0) {
@@ -109,72 +318,132 @@ bool UnixProcess::ReadAll(int fd, std::string& content, int timeoutMilliseconds)
     return false;
 }
 
-bool UnixProcess::Write(int fd, const wxString& message, atomic_bool& shutdown)
+bool UnixProcess::Write(int fd, const std::string_view* buffers, size_t count, atomic_bool& shutdown, int exitFd)
 {
-    int bytes = 0;
-    wxString tmp = message;
-    const int chunkSize = 4096;
-    while (!tmp.empty() && !shutdown.load()) {
-        errno = 0;
-        bytes = ::write(fd, tmp.c_str(), tmp.length() > chunkSize ? chunkSize : tmp.length());
-        int errCode = errno;
+    constexpr size_t kMaxIov = 64;
+    size_t index = 0;  // first buffer not completely written
+    size_t offset = 0; // bytes of buffers[index] already written
+    size_t total = 0;
+    SigpipeGuard noSigpipe;
+    while (!shutdown.load()) {
+        iovec iov[kMaxIov];
+        size_t iovCount = 0;
+        for (size_t i = index; i < count && iovCount < kMaxIov; ++i) {
+            size_t skip = (i == index) ? offset : 0;
+            if (buffers[i].size() == skip) {
+                continue;
+            }
+            iov[iovCount].iov_base = const_cast<char*>(buffers[i].data() + skip);
+            iov[iovCount].iov_len = buffers[i].size() - skip;
+            ++iovCount;
+        }
+        if (iovCount == 0) {
+            // all written
+            LOG_DEBUG() << "Wrote message of size:" << total;
+            return true;
+        }
+
+        ssize_t bytes = ::writev(fd, iov, static_cast<int>(iovCount));
         if (bytes < 0) {
-            if ((errCode == EWOULDBLOCK) || (errCode == EAGAIN)) {
-                this_thread::sleep_for(chrono::milliseconds(10));
-            } else if (errCode == EINTR) {
+            int errCode = errno;
+            if (errCode == EINTR) {
                 continue;
+            } else if ((errCode == EWOULDBLOCK) || (errCode == EAGAIN)) {
+                // wait for room in the pipe or for the process to exit, waking up now and then to check for shutdown
+                pollfd pfd[2] = {};
+                pfd[0].fd = fd;
+                pfd[0].events = POLLOUT;
+                pfd[1].fd = exitFd; // ignored by poll() when -1
+                pfd[1].events = POLLIN;
+                if (dap::Socket::Poll(pfd, 2, 100) < 0) {
+                    break;
+                }
+                if (pfd[0].revents & (POLLERR | POLLHUP | POLLNVAL)) {
+                    LOG_ERROR() << "Failed to write to process: pipe closed";
+                    break;
+                }
+                if (pfd[1].revents) {
+                    // a child of the process may still hold its stdin open, nobody is going to read it
+                    LOG_ERROR() << "Failed to write to process: process exited";
+                    break;
+                }
+                continue;
+            }
+            LOG_ERROR() << "Failed to write to process:" << strerror(errCode);
+            break;
+        }
+
+        total += bytes;
+        size_t left = static_cast<size_t>(bytes);
+        while (left > 0) {
+            size_t remaining = buffers[index].size() - offset;
+            if (left < remaining) {
+                offset += left;
+                left = 0;
             } else {
-                break;
+                left -= remaining;
+                ++index;
+                offset = 0;
             }
-        } else if (bytes) {
-            tmp.erase(0, bytes);
         }
     }
-    LOG_DEBUG() << "Wrote message of size:" << message.length();
-    return tmp.empty();
+    return false;
 }
 
 int UnixProcess::Wait()
 {
-    if (child_pid != -1) {
-        int status = 0;
-        waitpid(child_pid, &status, WNOHANG);
-        return WEXITSTATUS(status);
-    } else {
-        return 0;
+    if (!Reap()) {
+        // block until the child exits without reaping it, so Reap() collects the status under the lock
+        siginfo_t info = {};
+        while (::waitid(P_PID, child_pid, &info, WEXITED | WNOWAIT) == -1 && errno == EINTR) {
+        }
+        Reap();
     }
+    return GetExitCode();
 }
 
 void UnixProcess::Stop()
 {
-    if (child_pid != -1) {
+    if (IsAlive()) {
         ::kill(child_pid, SIGTERM);
     }
 }
 
 bool UnixProcess::Write(const std::string& message)
 {
-    return UnixProcess::Write(m_childStdin.GetWriteFd(), message, m_goingDown);
+    std::string_view view{ message };
+    return UnixProcess::Write(m_childStdin.GetWriteFd(), &view, 1, m_goingDown, m_exitFd);
+}
+
+bool UnixProcess::WriteBatch(const std::string_view* buffers, size_t count)
+{
+    return UnixProcess::Write(m_childStdin.GetWriteFd(), buffers, count, m_goingDown, m_exitFd);
 }
 
 bool UnixProcess::DoRead(std::string& str, std::string& err_buff)
 {
     if (!IsAlive()) {
         return false;
-    }
+    }
     ReadAll(m_childStdout.GetReadFd(), str, 10);
     ReadAll(m_childStderr.GetReadFd(), err_buff, 10);
     return !str.empty() || !err_buff.empty();
 }
 
-bool UnixProcess::IsAlive() const { return (::kill(child_pid, 0) == 0); }
+bool UnixProcess::IsAlive() const { return !Reap(); }
 
 void UnixProcess::Terminate()
 {
+    // a Write() waiting for room in the stdin pipe gives up
+    m_goingDown.store(true);
+    // never blocks: the exit is reported by IsAlive() / GetExitFd() once the process is gone
     Stop();
-    Wait();
 }
 
-bool UnixProcess::WriteLn(const std::string& message) { return Write(message + "\n"); }
+bool UnixProcess::WriteLn(const std::string& message)
+{
+    std::string_view buffers[] = { message, "\n" };
+    return WriteBatch(buffers, 2);
+}
 
 #endif // OSX & GTK
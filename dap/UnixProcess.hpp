@@ -8,9 +8,11 @@
 
 #include <atomic>
 #include <exception>
+#include <fcntl.h>
 #include <functional>
 #include <iostream>
 #include <memory>
+#include <mutex>
 #include <sys/wait.h>
 #include <thread>
 #include <unistd.h>
@@ -43,13 +45,22 @@ public:
     ~CPipe() { Close(); }
     bool Open()
     {
+        // close-on-exec: only the ends dup'ed onto the child stdio must be inherited
         int fd[2];
-        if (pipe(fd) == 0) {
-            m_readFd = fd[0];
-            m_writeFd = fd[1];
-            return true;
+#ifdef __linux__
+        if (pipe2(fd, O_CLOEXEC) != 0) {
+            return false;
         }
-        return false;
+#else
+        if (pipe(fd) != 0) {
+            return false;
+        }
+        fcntl(fd[0], F_SETFD, FD_CLOEXEC);
+        fcntl(fd[1], F_SETFD, FD_CLOEXEC);
+#endif
+        m_readFd = fd[0];
+        m_writeFd = fd[1];
+        return true;
     }
     void CloseWriteFd() { CLOSE_FD(m_writeFd); }
     void CloseReadFd() { CLOSE_FD(m_readFd); }
@@ -64,11 +75,25 @@ private:
     atomic_bool m_goingDown;
     std::string m_stdout;
     std::string m_stderr;
+    int m_exitFd = -1;
+    mutable std::mutex m_reapLock;
+    mutable bool m_reaped = false;
+    mutable int m_exitCode = -1;
+
+    /// open the descriptor returned by GetExitFd()
+    void OpenExitFd();
+    /// start the child with the pipes as its stdio. Return its pid, or -1 (and errno) on failure
+    pid_t Spawn(char* const* argv);
+    /// collect the child exit status if it has exited, never blocks. Return true if the child is gone
+    bool Reap() const;
 
 protected:
     // sync operations
     static bool ReadAll(int fd, std::string& content, int timeoutMilliseconds);
-    static bool Write(int fd, const wxString& message, atomic_bool& shutdown);
+    /// write all of `buffers` to `fd` with writev(), waiting in poll() while the pipe is full. Give up when `shutdown`
+    /// is set, the pipe is closed or `exitFd` (see GetExitFd(), may be -1) reports the process exit. A closed pipe never
+    /// raises SIGPIPE
+    static bool Write(int fd, const std::string_view* buffers, size_t count, atomic_bool& shutdown, int exitFd);
 
     bool DoRead(std::string& str, std::string& err_buff) override;
 
@@ -78,7 +103,7 @@ public:
     UnixProcess(const vector<wxString>& args);
     virtual ~UnixProcess();
 
-    // wait for process termination
+    // wait for process termination, return its exit code
     int Wait();
 
     // Write to the process
@@ -87,6 +112,8 @@ public:
     // Same as Write, but add LF at the end of the message
     bool WriteLn(const std::string& message) override;
 
+    bool WriteBatch(const std::string_view* buffers, size_t count) override;
+
     // stop the running process
     void Stop();
 
@@ -96,9 +123,15 @@ public:
     bool IsAlive() const override;
 
     /**
-     * @brief terminate the process
+     * @brief ask the process to terminate (SIGTERM), without waiting for it. A process still running when this object
+     * is deleted is killed after a grace period, in the background
      */
     void Terminate() override;
+
+    int GetStdoutFd() const override { return m_childStdout.GetReadFd(); }
+    int GetStderrFd() const override { return m_childStderr.GetReadFd(); }
+    int GetExitFd() const override { return m_exitFd; }
+    int GetExitCode() const override;
 };
 #endif // defined(__linux__)
 #endif // UNIX_PROCESS_H
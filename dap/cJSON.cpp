@@ -35,7 +35,8 @@
 
 namespace dap {
 // clang-format on
-static const char* ep;
+/* the error position of the last parse on this thread: messages are parsed on the reader thread and the main thread */
+static thread_local const char* ep;
 #define FMT_WHITESPACE_CHAR ' '
 
 const char* cJSON_GetErrorPtr() { return ep; }
@@ -79,10 +80,108 @@ void cJSON_InitHooks(cJSONDap_Hooks* hooks)
     cJSON_free = (hooks->free_fn) ? hooks->free_fn : free;
 }
 
+/* Arena allocator. Blocks are chained, allocations are never freed individually */
+typedef struct cJsonDapArenaBlock {
+    struct cJsonDapArenaBlock* next;
+    size_t size;
+    size_t used;
+} cJsonDapArenaBlock;
+
+struct cJsonDapArena {
+    cJsonDapArenaBlock* head; /* the block we are currently allocating from */
+    size_t blockSize;
+};
+
+/* All arena allocations are aligned to this, so nodes, doubles and strings can share a block */
+#define CJSON_ARENA_ALIGN 16
+#define CJSON_ARENA_ALIGN_UP(n) (((n) + (CJSON_ARENA_ALIGN - 1)) & ~(size_t)(CJSON_ARENA_ALIGN - 1))
+#define CJSON_ARENA_HEADER CJSON_ARENA_ALIGN_UP(sizeof(cJsonDapArenaBlock))
+/* Don't keep more than this around between two uses of the same arena */
+#define CJSON_ARENA_MAX_RETAIN (4 * 1024 * 1024)
+
+static cJsonDapArenaBlock* cJSON_ArenaNewBlock(size_t size)
+{
+    cJsonDapArenaBlock* block = (cJsonDapArenaBlock*)cJSON_malloc(CJSON_ARENA_HEADER + size);
+    if(!block)
+        return 0;
+    block->next = 0;
+    block->size = size;
+    block->used = 0;
+    return block;
+}
+
+cJsonDapArena* cJSON_ArenaCreate(size_t blockSize)
+{
+    cJsonDapArena* arena = (cJsonDapArena*)cJSON_malloc(sizeof(cJsonDapArena));
+    if(!arena)
+        return 0;
+    arena->head = 0;
+    arena->blockSize = CJSON_ARENA_ALIGN_UP(blockSize ? blockSize : 4096);
+    return arena;
+}
+
+void* cJSON_ArenaAlloc(cJsonDapArena* arena, size_t size)
+{
+    cJsonDapArenaBlock* block = arena->head;
+    size = CJSON_ARENA_ALIGN_UP(size);
+    if(!block || block->size - block->used < size) {
+        /* grow geometrically, so a large message ends up in a handful of blocks */
+        size_t blockSize = block ? block->size * 2 : arena->blockSize;
+        while(blockSize < size)
+            blockSize *= 2;
+        if(!(block = cJSON_ArenaNewBlock(blockSize)))
+            return 0;
+        block->next = arena->head;
+        arena->head = block;
+    }
+    void* p = (char*)block + CJSON_ARENA_HEADER + block->used;
+    block->used += size;
+    return p;
+}
+
+void cJSON_ArenaReset(cJsonDapArena* arena)
+{
+    cJsonDapArenaBlock* block = arena->head;
+    if(!block)
+        return;
+
+    /* the head block is always the largest one. Keep it for the next message, unless it got too big */
+    cJsonDapArenaBlock* next = block->next;
+    block->next = 0;
+    block->used = 0;
+    if(block->size > CJSON_ARENA_MAX_RETAIN) {
+        cJSON_free(block);
+        arena->head = 0;
+    }
+    while(next) {
+        block = next;
+        next = block->next;
+        cJSON_free(block);
+    }
+}
+
+void cJSON_ArenaDelete(cJsonDapArena* arena)
+{
+    if(!arena)
+        return;
+    cJSON_ArenaReset(arena);
+    if(arena->head)
+        cJSON_free(arena->head);
+    cJSON_free(arena);
+}
+
+/* When set, the parser allocates from this arena instead of the heap */
+static thread_local cJsonDapArena* parse_arena = 0;
+
+static void* cJSON_parse_malloc(size_t sz)
+{
+    return parse_arena ? cJSON_ArenaAlloc(parse_arena, sz) : cJSON_malloc(sz);
+}
+
 /* Internal constructor. */
 static cJsonDap* cJSON_New_Item()
 {
-    cJsonDap* node = (cJsonDap*)cJSON_malloc(sizeof(cJsonDap));
+    cJsonDap* node = (cJsonDap*)cJSON_parse_malloc(sizeof(cJsonDap));
     if(node)
         memset(node, 0, sizeof(cJsonDap));
     return node;
@@ -100,6 +199,8 @@ void cJSON_Delete(cJsonDap* c)
             cJSON_free(c->valuestring);
         if(c->string)
             cJSON_free(c->string);
+        if(c->index)
+            cJSON_free(c->index);
         cJSON_free(c);
         c = next;
     }
@@ -186,7 +287,7 @@ static const char* parse_string(cJsonDap* item, const char* str)
         if(*ptr++ == '\\')
             ptr++; /* Skip escaped quotes. */
 
-    out = (char*)cJSON_malloc(len + 1); /* This is how long we need for the string, roughly. */
+    out = (char*)cJSON_parse_malloc(len + 1); /* This is how long we need for the string, roughly. */
     if(!out)
         return 0;
 
@@ -368,6 +469,33 @@ cJsonDap* cJSON_Parse(const char* value)
     return c;
 }
 
+cJsonDap* cJSON_ParseWithArena(const char* value, cJsonDapArena* arena)
+{
+    parse_arena = arena;
+    cJsonDap* c = cJSON_New_Item();
+    ep = 0;
+    if(c && !parse_value(c, skip(value)))
+        c = 0; /* whatever was allocated goes away with the arena */
+    parse_arena = 0;
+    return c;
+}
+
+cJsonDap* cJSON_ParseWithLength(const char* value, size_t len, cJsonDapArena* arena)
+{
+    char* copy = (char*)(arena ? cJSON_ArenaAlloc(arena, len + 1) : cJSON_malloc(len + 1));
+    if(!copy)
+        return 0; /* memory fail */
+    memcpy(copy, value, len);
+    copy[len] = 0;
+
+    cJsonDap* c = arena ? cJSON_ParseWithArena(copy, arena) : cJSON_Parse(copy);
+    if(ep)
+        ep = value + (ep - copy); /* report the error position in the caller's buffer */
+    if(!arena)
+        cJSON_free(copy);
+    return c;
+}
+
 /* Render a cJsonDap item/entity/structure to text. */
 char* cJSON_Print(cJsonDap* item) { return print_value(item, 0, 1); }
 char* cJSON_PrintUnformatted(cJsonDap* item) { return print_value(item, 0, 0); }
@@ -545,9 +673,12 @@ static char* print_array(cJsonDap* item, int depth, int fmt)
 }
 
 /* Build an object from the text. */
+static void cJSON_IndexObject(cJsonDap* object, size_t count);
+
 static const char* parse_object(cJsonDap* item, const char* value)
 {
     cJsonDap* child;
+    size_t count = 1;
     if(*value != '{') {
         ep = value;
         return 0;
@@ -581,6 +712,7 @@ static const char* parse_object(cJsonDap* item, const char* value)
         child->next = new_item;
         new_item->prev = child;
         child = new_item;
+        ++count;
         value = skip(parse_string(child, skip(value + 1)));
         if(!value)
             return 0;
@@ -595,8 +727,10 @@ static const char* parse_object(cJsonDap* item, const char* value)
             return 0;
     }
 
-    if(*value == '}')
+    if(*value == '}') {
+        cJSON_IndexObject(item, count);
         return value + 1; /* end of array */
+    }
     ep = value;
     return 0; /* malformed. */
 }
@@ -718,6 +852,90 @@ cJsonDap* cJSON_GetObjectItem(cJsonDap* object, const char* string)
     return c;
 }
 
+/* Object member index: an open addressing hash table of the object's children */
+struct cJsonDapIndex {
+    size_t mask;
+    cJsonDap* slots[1];
+};
+
+/* Objects with up to this many members are searched linearly */
+#define CJSON_INDEX_MIN_MEMBERS 8
+
+static size_t cJSON_hash(const char* key, size_t len)
+{
+    /* FNV-1a */
+    size_t h = 2166136261u;
+    for(size_t i = 0; i < len; ++i) {
+        h ^= (unsigned char)key[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static int cJSON_keyeq(const char* name, const char* key, size_t len)
+{
+    return name && strncmp(name, key, len) == 0 && name[len] == 0;
+}
+
+static void cJSON_DropIndex(cJsonDap* object)
+{
+    /* arena objects are read-only, so any index we get to drop was allocated on the heap by cJSON_Parse() */
+    if(object->index) {
+        cJSON_free(object->index);
+        object->index = 0;
+    }
+}
+
+/* Called by the parser once an object is complete: index it if it is large. The index is allocated like the nodes
+ * (from the parse arena or the heap), the tree is never modified by lookups so it can be read from any thread */
+static void cJSON_IndexObject(cJsonDap* object, size_t count)
+{
+    if(count <= CJSON_INDEX_MIN_MEMBERS)
+        return;
+
+    size_t slots = 16;
+    while(slots < count * 2)
+        slots *= 2;
+
+    size_t size = sizeof(cJsonDapIndex) + (slots - 1) * sizeof(cJsonDap*);
+    cJsonDapIndex* index = (cJsonDapIndex*)cJSON_parse_malloc(size);
+    if(!index)
+        return; /* lookups fall back to a linear search */
+    memset(index, 0, size);
+    index->mask = slots - 1;
+
+    /* insert in member order: on duplicate names the first member sits first on the probe sequence, just like a
+     * linear search would find it */
+    for(cJsonDap* c = object->child; c; c = c->next) {
+        if(!c->string)
+            continue;
+        size_t pos = cJSON_hash(c->string, strlen(c->string)) & index->mask;
+        while(index->slots[pos])
+            pos = (pos + 1) & index->mask;
+        index->slots[pos] = c;
+    }
+    object->index = index;
+}
+
+cJsonDap* cJSON_FindObjectItem(const cJsonDap* object, const char* key, size_t len)
+{
+    const cJsonDapIndex* index = object->index;
+    if(!index) {
+        for(cJsonDap* c = object->child; c; c = c->next)
+            if(cJSON_keyeq(c->string, key, len))
+                return c;
+        return 0;
+    }
+
+    size_t pos = cJSON_hash(key, len) & index->mask;
+    while(index->slots[pos]) {
+        if(cJSON_keyeq(index->slots[pos]->string, key, len))
+            return index->slots[pos];
+        pos = (pos + 1) & index->mask;
+    }
+    return 0;
+}
+
 /* Utility for array list handling. */
 static void suffix_object(cJsonDap* prev, cJsonDap* item)
 {
@@ -732,6 +950,7 @@ static cJsonDap* create_reference(cJsonDap* item)
         return 0;
     memcpy(ref, item, sizeof(cJsonDap));
     ref->string = 0;
+    ref->index = 0;
     ref->type |= cJsonDap_IsReference;
     ref->next = ref->prev = 0;
     return ref;
@@ -743,6 +962,7 @@ void cJSON_AddItemToArray(cJsonDap* array, cJsonDap* item)
     cJsonDap* c = array->child;
     if(!item)
         return;
+    cJSON_DropIndex(array);
     if(!c) {
         array->child = item;
     } else {
@@ -776,6 +996,7 @@ cJsonDap* cJSON_DetachItemFromArray(cJsonDap* array, int which)
         c = c->next, which--;
     if(!c)
         return 0;
+    cJSON_DropIndex(array);
     if(c->prev)
         c->prev->next = c->next;
     if(c->next)
@@ -809,6 +1030,7 @@ void cJSON_ReplaceItemInArray(cJsonDap* array, int which, cJsonDap* newitem)
         c = c->next, which--;
     if(!c)
         return;
+    cJSON_DropIndex(array);
     newitem->next = c->next;
     newitem->prev = c->prev;
     if(newitem->next)
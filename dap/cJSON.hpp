@@ -39,6 +39,8 @@
 
 namespace dap
 {
+struct cJsonDapIndex;
+
 /* The cJsonDap structure: */
 typedef struct cJsonDap {
     struct cJsonDap *next, *prev; /* next/prev allow you to walk array/object chains. Alternatively, use
@@ -54,6 +56,8 @@ typedef struct cJsonDap {
 
     char*
         string; /* The item's name string, if this item is the child of, or is in the list of subitems of an object. */
+
+    struct cJsonDapIndex* index; /* Hash index of a large parsed object's members, see cJSON_FindObjectItem() */
 } cJsonDap;
 
 typedef struct cJSONDap_Hooks {
@@ -61,11 +65,21 @@ typedef struct cJSONDap_Hooks {
     void (*free_fn)(void* ptr);
 } cJSONDap_Hooks;
 
+/* A bump allocator. Every node and string of a tree parsed with cJSON_ParseWithArena() is carved out of the arena's
+ * blocks, so the whole tree is released in one step by cJSON_ArenaReset() or cJSON_ArenaDelete(). Such trees must not be
+ * passed to cJSON_Delete() and must not be modified. */
+typedef struct cJsonDapArena cJsonDapArena;
+
 /* Supply malloc, realloc and free functions to cJsonDap */
 WXDLLIMPEXP_DAP void cJSON_InitHooks(cJSONDap_Hooks* hooks);
 
 /* Supply a block of Json, and this returns a cJsonDap object you can interrogate. Call cJSON_Delete when finished. */
 WXDLLIMPEXP_DAP cJsonDap* cJSON_Parse(const char* value);
+/* Same as cJSON_Parse(), but allocate the tree from arena. Do not call cJSON_Delete on the result */
+WXDLLIMPEXP_DAP cJsonDap* cJSON_ParseWithArena(const char* value, cJsonDapArena* arena);
+/* Parse exactly len bytes of value, which does not need to be NULL terminated. The text is copied once into a
+ * terminated scratch buffer (allocated from arena when one is given, the result is then owned by the arena) */
+WXDLLIMPEXP_DAP cJsonDap* cJSON_ParseWithLength(const char* value, size_t len, cJsonDapArena* arena);
 /* Render a cJsonDap entity to text for transfer/storage. Free the char* when finished. */
 WXDLLIMPEXP_DAP char* cJSON_Print(cJsonDap* item);
 /* Render a cJsonDap entity to text for transfer/storage without any formatting. Free the char* when finished. */
@@ -73,15 +87,29 @@ WXDLLIMPEXP_DAP char* cJSON_PrintUnformatted(cJsonDap* item);
 /* Delete a cJsonDap entity and all subentities. */
 WXDLLIMPEXP_DAP void cJSON_Delete(cJsonDap* c);
 
+/* Create an arena. blockSize is the size of the first block, further blocks grow geometrically */
+WXDLLIMPEXP_DAP cJsonDapArena* cJSON_ArenaCreate(size_t blockSize);
+/* Allocate size bytes from the arena (aligned for any cJsonDap member). Returns NULL on memory fail */
+WXDLLIMPEXP_DAP void* cJSON_ArenaAlloc(cJsonDapArena* arena, size_t size);
+/* Release everything allocated from the arena, keeping (at most) one block around for the next use */
+WXDLLIMPEXP_DAP void cJSON_ArenaReset(cJsonDapArena* arena);
+/* Release the arena and all its blocks */
+WXDLLIMPEXP_DAP void cJSON_ArenaDelete(cJsonDapArena* arena);
+
 /* Returns the number of items in an array (or object). */
 WXDLLIMPEXP_DAP int cJSON_GetArraySize(cJsonDap* array);
 /* Retrieve item number "item" from array "array". Returns NULL if unsuccessful. */
 WXDLLIMPEXP_DAP cJsonDap* cJSON_GetArrayItem(cJsonDap* array, int item);
 /* Get item "string" from object. Case insensitive. */
 WXDLLIMPEXP_DAP cJsonDap* cJSON_GetObjectItem(cJsonDap* object, const char* string);
+/* Get item "key" (len bytes, not necessarily NULL terminated) from object. Case sensitive.
+ * Parsed objects with more than a few members are indexed by the parser, making lookups O(1). The lookup never modifies
+ * the tree */
+WXDLLIMPEXP_DAP cJsonDap* cJSON_FindObjectItem(const cJsonDap* object, const char* key, size_t len);
 
 /* For analysing failed parses. This returns a pointer to the parse error. You'll probably need to look a few chars back
- * to make sense of it. Defined when cJSON_Parse() returns 0. 0 when cJSON_Parse() succeeds. */
+ * to make sense of it. Defined when cJSON_Parse() returns 0. 0 when cJSON_Parse() succeeds. Per thread: it describes the
+ * last parse made by the calling thread */
 WXDLLIMPEXP_DAP const char* cJSON_GetErrorPtr();
 
 /* These calls create a cJsonDap item of the appropriate type. */
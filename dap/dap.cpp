@@ -2,6 +2,8 @@
 
 #include "Socket.hpp"
 
+#include <mutex>
+
 #define CREATE_JSON() Json json = Json::CreateObject()
 #define REQUEST_TO() Json json = Request::To()
 #define RESPONSE_TO() Json json = Response::To()
@@ -25,9 +27,14 @@
 
 #define GET_BODY_PROP(prop, Type) prop = body[#prop].Get##Type()
 
+#define WRITE_PROP(prop) writer.Add(#prop, prop)
+#define WRITE_OBJ(obj) obj.Write(writer.Key(#obj))
+
 namespace dap
 {
-void Initialize()
+namespace
+{
+void RegisterClasses()
 {
     REGISTER_CLASS(CancelRequest);
     REGISTER_CLASS(InitializeRequest);
@@ -87,6 +94,15 @@ void Initialize()
     // Needed for windows socket library
     Socket::Initialize();
 }
+} // namespace
+
+void Initialize()
+{
+    // after this, the message constructors find their class registered and only take a shared lock
+    static std::once_flag once;
+    std::call_once(once, RegisterClasses);
+}
+
 ObjGenerator& ObjGenerator::Get()
 {
     static ObjGenerator generator;
@@ -106,37 +122,68 @@ ProtocolMessage::Ptr_t ObjGenerator::New(const wxString& type, const wxString& n
     }
 }
 
+void Any::Write(JsonWriter& writer) const { writer.Value(To()); }
+
 wxString dap::ProtocolMessage::ToString() const
 {
     Json json = To();
     return json.ToString(false);
 }
 
-void ObjGenerator::RegisterResponse(const wxString& name, onNewObject func)
+void ObjGenerator::Register(const wxString& name, onNewObject func, Pool& pool)
 {
-    // register new response class
-    m_responses.insert({ name, func });
+    auto cb = name.mb_str(wxConvUTF8);
+    eMessageName id = FindMessageName(std::string_view(cb.data(), cb.length()));
+    std::unique_lock<std::shared_mutex> lock(m_lock);
+    if (id == eMessageName::kUnknown) {
+        pool.other.insert({ name, std::move(func) });
+    } else if (!pool.known[static_cast<size_t>(id)]) {
+        pool.known[static_cast<size_t>(id)] = std::move(func);
+    }
 }
 
-void ObjGenerator::RegisterEvent(const wxString& name, onNewObject func)
+void ObjGenerator::Register(const char* name, onNewObject func, Pool& pool)
 {
-    // register new event class
-    m_events.insert({ name, func });
+    // the message constructors register themselves, so this is called for every message we build: keep the common
+    // case (an already registered, known name) down to a hash and a shared lock
+    eMessageName id = FindMessageName(name);
+    if (id != eMessageName::kUnknown) {
+        std::shared_lock<std::shared_mutex> lock(m_lock);
+        if (pool.known[static_cast<size_t>(id)]) {
+            return;
+        }
+    }
+    Register(wxString::FromUTF8(name), std::move(func), pool);
 }
 
-void ObjGenerator::RegisterRequest(const wxString& name, onNewObject func)
+ProtocolMessage::Ptr_t ObjGenerator::New(const wxString& name, const Pool& pool)
 {
-    // register new request class
-    m_requests.insert({ name, func });
+    auto cb = name.mb_str(wxConvUTF8);
+    eMessageName id = FindMessageName(std::string_view(cb.data(), cb.length()));
+    if (id != eMessageName::kUnknown) {
+        return New(id, pool);
+    }
+    onNewObject func;
+    {
+        std::shared_lock<std::shared_mutex> lock(m_lock);
+        const auto& iter = pool.other.find(name);
+        if (iter == pool.other.end()) {
+            return nullptr;
+        }
+        func = iter->second;
+    }
+    // the constructor registers the class: call it without holding the lock
+    return func();
 }
 
-ProtocolMessage::Ptr_t ObjGenerator::New(const wxString& name, const unordered_map<wxString, onNewObject>& pool)
+ProtocolMessage::Ptr_t ObjGenerator::New(eMessageName name, const Pool& pool)
 {
-    const auto& iter = pool.find(name);
-    if (iter == pool.end()) {
-        return nullptr;
+    onNewObject func;
+    {
+        std::shared_lock<std::shared_mutex> lock(m_lock);
+        func = pool.known[static_cast<size_t>(name)];
     }
-    return iter->second();
+    return func ? func() : nullptr;
 }
 
 ProtocolMessage::Ptr_t dap::ObjGenerator::FromJSON(Json json)
@@ -144,9 +191,26 @@ ProtocolMessage::Ptr_t dap::ObjGenerator::FromJSON(Json json)
     if (!json.IsOK()) {
         return nullptr;
     }
-    wxString type = json["type"].GetString();
-    wxString command = (type == "event") ? json["event"].GetString() : json["command"].GetString();
-    ProtocolMessage::Ptr_t msg = New(type, command);
+    std::string_view type = json["type"].GetStringView();
+    const Pool* pool = nullptr;
+    std::string_view name;
+    if (type == "event") {
+        pool = &m_events;
+        name = json["event"].GetStringView();
+    } else if (type == "response") {
+        pool = &m_responses;
+        name = json["command"].GetStringView();
+    } else if (type == "request") {
+        pool = &m_requests;
+        name = json["command"].GetStringView();
+    } else {
+        return nullptr;
+    }
+
+    eMessageName id = FindMessageName(name);
+    ProtocolMessage::Ptr_t msg = (id == eMessageName::kUnknown)
+                                     ? New(wxString::FromUTF8(name.data(), name.length()), *pool)
+                                     : New(id, *pool);
     if (!msg) {
         return nullptr;
     }
@@ -171,6 +235,12 @@ Json ProtocolMessage::To() const
     return json;
 }
 
+void ProtocolMessage::WriteFields(JsonWriter& writer) const
+{
+    WRITE_PROP(seq);
+    WRITE_PROP(type);
+}
+
 void ProtocolMessage::From(const Json& json)
 {
     GET_PROP(seq, Number);
@@ -189,6 +259,12 @@ Json Request::To() const
     return json;
 }
 
+void Request::WriteFields(JsonWriter& writer) const
+{
+    ProtocolMessage::WriteFields(writer);
+    WRITE_PROP(command);
+}
+
 void Request::From(const Json& json)
 {
     PROTOCOL_MSG_FROM();
@@ -408,6 +484,19 @@ Json Source::To() const
     return json;
 }
 
+void Source::Write(JsonWriter& writer) const
+{
+    writer.BeginObject();
+    WRITE_PROP(name);
+    if (!path.empty()) {
+        WRITE_PROP(path);
+    }
+    if (sourceReference > 0) {
+        WRITE_PROP(sourceReference);
+    }
+    writer.EndObject();
+}
+
 void Source::From(const Json& json)
 {
     GET_PROP(name, String);
@@ -802,6 +891,15 @@ Json StepArguments::To() const
     return json;
 }
 
+void StepArguments::Write(JsonWriter& writer) const
+{
+    writer.BeginObject();
+    WRITE_PROP(threadId);
+    WRITE_PROP(singleThread);
+    WRITE_PROP(granularity);
+    writer.EndObject();
+}
+
 void StepArguments::From(const Json& json)
 {
     threadId = json["threadId"].GetInteger(wxNOT_FOUND);
@@ -1017,6 +1115,14 @@ Json ContinueArguments::To() const
     return json;
 }
 
+void ContinueArguments::Write(JsonWriter& writer) const
+{
+    writer.BeginObject();
+    WRITE_PROP(threadId);
+    WRITE_PROP(singleThread);
+    writer.EndObject();
+}
+
 void ContinueArguments::From(const Json& json)
 {
     GET_PROP(threadId, Integer);
@@ -1036,6 +1142,15 @@ Json NextArguments::To() const
     return json;
 }
 
+void NextArguments::Write(JsonWriter& writer) const
+{
+    writer.BeginObject();
+    WRITE_PROP(threadId);
+    WRITE_PROP(granularity);
+    WRITE_PROP(singleThread);
+    writer.EndObject();
+}
+
 void NextArguments::From(const Json& json)
 {
     GET_PROP(threadId, Integer);
@@ -1054,6 +1169,14 @@ Json ContinueRequest::To() const
     return json;
 }
 
+void ContinueRequest::Write(JsonWriter& writer) const
+{
+    writer.BeginObject();
+    Request::WriteFields(writer);
+    WRITE_OBJ(arguments);
+    writer.EndObject();
+}
+
 void ContinueRequest::From(const Json& json)
 {
     REQUEST_FROM();
@@ -1070,6 +1193,14 @@ Json StepRequest::To() const
     return json;
 }
 
+void StepRequest::Write(JsonWriter& writer) const
+{
+    writer.BeginObject();
+    Request::WriteFields(writer);
+    WRITE_OBJ(arguments);
+    writer.EndObject();
+}
+
 void StepRequest::From(const Json& json)
 {
     REQUEST_FROM();
@@ -1087,6 +1218,14 @@ Json NextRequest::To() const
     return json;
 }
 
+void NextRequest::Write(JsonWriter& writer) const
+{
+    writer.BeginObject();
+    Request::WriteFields(writer);
+    WRITE_OBJ(arguments);
+    writer.EndObject();
+}
+
 void NextRequest::From(const Json& json)
 {
     REQUEST_FROM();
@@ -1103,6 +1242,13 @@ Json ThreadsRequest::To() const
     return json;
 }
 
+void ThreadsRequest::Write(JsonWriter& writer) const
+{
+    writer.BeginObject();
+    Request::WriteFields(writer);
+    writer.EndObject();
+}
+
 void ThreadsRequest::From(const Json& json) { REQUEST_FROM(); }
 
 // ----------------------------------------
@@ -1240,6 +1386,13 @@ Json ScopesArguments::To() const
     return json;
 }
 
+void ScopesArguments::Write(JsonWriter& writer) const
+{
+    writer.BeginObject();
+    WRITE_PROP(frameId);
+    writer.EndObject();
+}
+
 void ScopesArguments::From(const Json& json) { frameId = json["frameId"].GetNumber(); }
 
 // ----------------------------------------
@@ -1253,6 +1406,14 @@ Json ScopesRequest::To() const
     return json;
 }
 
+void ScopesRequest::Write(JsonWriter& writer) const
+{
+    writer.BeginObject();
+    Request::WriteFields(writer);
+    WRITE_OBJ(arguments);
+    writer.EndObject();
+}
+
 void ScopesRequest::From(const Json& json)
 {
     Request::From(json);
@@ -1320,6 +1481,13 @@ Json StackTraceArguments::To() const
     return json;
 }
 
+void StackTraceArguments::Write(JsonWriter& writer) const
+{
+    writer.BeginObject();
+    WRITE_PROP(threadId);
+    writer.EndObject();
+}
+
 void StackTraceArguments::From(const Json& json)
 {
     threadId = json["threadId"].GetInteger();
@@ -1340,6 +1508,13 @@ Json ValueFormat::To() const
     return json;
 }
 
+void ValueFormat::Write(JsonWriter& writer) const
+{
+    writer.BeginObject();
+    WRITE_PROP(hex);
+    writer.EndObject();
+}
+
 void ValueFormat::From(const Json& json) { hex = json["hex"].GetBool(); }
 
 // ----------------------------------------
@@ -1355,6 +1530,15 @@ Json VariablesArguments::To() const
     return json;
 }
 
+void VariablesArguments::Write(JsonWriter& writer) const
+{
+    writer.BeginObject();
+    WRITE_PROP(variablesReference);
+    WRITE_PROP(count);
+    WRITE_OBJ(format);
+    writer.EndObject();
+}
+
 void VariablesArguments::From(const Json& json)
 {
     variablesReference = json["variablesReference"].GetInteger();
@@ -1373,6 +1557,14 @@ Json StackTraceRequest::To() const
     return json;
 }
 
+void StackTraceRequest::Write(JsonWriter& writer) const
+{
+    writer.BeginObject();
+    Request::WriteFields(writer);
+    WRITE_OBJ(arguments);
+    writer.EndObject();
+}
+
 void StackTraceRequest::From(const Json& json)
 {
     Request::From(json);
@@ -1418,6 +1610,14 @@ Json VariablesRequest::To() const
     return json;
 }
 
+void VariablesRequest::Write(JsonWriter& writer) const
+{
+    writer.BeginObject();
+    Request::WriteFields(writer);
+    WRITE_OBJ(arguments);
+    writer.EndObject();
+}
+
 void VariablesRequest::From(const Json& json)
 {
     Request::From(json);
@@ -1459,6 +1659,13 @@ Json PauseArguments::To() const
     return json;
 }
 
+void PauseArguments::Write(JsonWriter& writer) const
+{
+    writer.BeginObject();
+    WRITE_PROP(threadId);
+    writer.EndObject();
+}
+
 Json PauseRequest::To() const
 {
     auto json = Request::To();
@@ -1466,6 +1673,14 @@ Json PauseRequest::To() const
     return json;
 }
 
+void PauseRequest::Write(JsonWriter& writer) const
+{
+    writer.BeginObject();
+    Request::WriteFields(writer);
+    WRITE_OBJ(arguments);
+    writer.EndObject();
+}
+
 void PauseRequest::From(const Json& json)
 {
     Request::From(json);
@@ -1534,6 +1749,16 @@ Json SourceArguments::To() const
     return json;
 }
 
+void SourceArguments::Write(JsonWriter& writer) const
+{
+    writer.BeginObject();
+    WRITE_OBJ(source);
+    if (sourceReference > 0) {
+        WRITE_PROP(sourceReference);
+    }
+    writer.EndObject();
+}
+
 void SourceRequest::From(const Json& json)
 {
     REQUEST_FROM();
@@ -1547,6 +1772,14 @@ Json SourceRequest::To() const
     return json;
 }
 
+void SourceRequest::Write(JsonWriter& writer) const
+{
+    writer.BeginObject();
+    Request::WriteFields(writer);
+    WRITE_OBJ(arguments);
+    writer.EndObject();
+}
+
 Json SourceResponse::To() const
 {
     RESPONSE_TO();
@@ -1576,6 +1809,18 @@ Json EvaluateArguments::To() const
     return json;
 }
 
+void EvaluateArguments::Write(JsonWriter& writer) const
+{
+    writer.BeginObject();
+    WRITE_PROP(expression);
+    if (frameId > 0) {
+        WRITE_PROP(frameId);
+    }
+    WRITE_PROP(context);
+    WRITE_OBJ(format);
+    writer.EndObject();
+}
+
 void EvaluateArguments::From(const Json& json)
 {
     expression = json["expression"].GetString(expression);
@@ -1591,6 +1836,14 @@ Json EvaluateRequest::To() const
     return json;
 }
 
+void EvaluateRequest::Write(JsonWriter& writer) const
+{
+    writer.BeginObject();
+    Request::WriteFields(writer);
+    WRITE_OBJ(arguments);
+    writer.EndObject();
+}
+
 void EvaluateRequest::From(const Json& json)
 {
     REQUEST_FROM();
@@ -1685,4 +1938,48 @@ void DebugpyWaitingForServerEvent::From(const Json& json)
     host = body["host"].GetString();
     port = body["port"].GetInteger();
 }
+
+Json StopSnapshot::To() const
+{
+    Json json = Json::CreateObject();
+    json.Add("threadId", threadId);
+    if (stackTrace) {
+        json.Add("stackTrace", stackTrace->To());
+    }
+    if (scopes) {
+        json.Add("scopes", scopes->To());
+    }
+    auto arr = json.AddArray("variables");
+    for (const auto& response : variables) {
+        arr.Add(response ? response->To() : Json::CreateObject());
+    }
+    return json;
+}
+
+void StopSnapshot::From(const Json& json)
+{
+    threadId = json["threadId"].GetInteger();
+    stackTrace.reset();
+    if (json["stackTrace"].IsOK()) {
+        stackTrace = std::make_shared<StackTraceResponse>();
+        stackTrace->From(json["stackTrace"]);
+    }
+    scopes.reset();
+    if (json["scopes"].IsOK()) {
+        scopes = std::make_shared<ScopesResponse>();
+        scopes->From(json["scopes"]);
+    }
+    auto arr = json["variables"];
+    size_t count = arr.GetCount();
+    variables.clear();
+    variables.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        std::shared_ptr<VariablesResponse> response;
+        if (arr[i]["type"].IsOK()) {
+            response = std::make_shared<VariablesResponse>();
+            response->From(arr[i]);
+        }
+        variables.push_back(response);
+    }
+}
 }; // namespace dap
@@ -2,10 +2,14 @@
 #define PROTOCOLMESSAGE_HPP
 
 #include "JSON.hpp"
+#include "JsonWriter.hpp"
+#include "MessageNames.hpp"
 #include "dap_exports.hpp"
 
+#include <array>
 #include <functional>
 #include <memory>
+#include <shared_mutex>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -30,6 +34,10 @@ struct hash<wxString> {
     Json To() const override; \
     void From(const Json& json) override
 
+/// Classes that are serialized often implement this on top of JSON_SERIALIZE() to skip the intermediate Json tree.
+/// The output must be identical to To()
+#define JSON_WRITE() void Write(JsonWriter& writer) const override
+
 #define REQUEST_CLASS(Type, Command)                              \
     Type()                                                        \
     {                                                             \
@@ -117,6 +125,11 @@ struct WXDLLIMPEXP_DAP Any {
     virtual Json To() const = 0;
     virtual void From(const Json& json) = 0;
 
+    /**
+     * @brief serialize this object directly into `writer`. The default implementation writes the tree built by To()
+     */
+    virtual void Write(JsonWriter& writer) const;
+
     template <typename T>
     T* As() const
     {
@@ -163,17 +176,34 @@ struct WXDLLIMPEXP_DAP ProtocolMessage : public Any {
     wxString ToString() const;
     ANY_CLASS(ProtocolMessage);
     JSON_SERIALIZE();
+
+protected:
+    /// write the ProtocolMessage members into an already open object (used by the Write() implementations)
+    void WriteFields(JsonWriter& writer) const;
 };
 
 class WXDLLIMPEXP_DAP ObjGenerator
 {
     typedef std::function<ProtocolMessage::Ptr_t()> onNewObject;
-    std::unordered_map<wxString, onNewObject> m_responses;
-    std::unordered_map<wxString, onNewObject> m_events;
-    std::unordered_map<wxString, onNewObject> m_requests;
+
+    /// factories of one message type, indexed by the name id. Names that are not part of `eMessageName` are kept
+    /// in a map
+    struct Pool {
+        std::array<onNewObject, static_cast<size_t>(eMessageName::kCount)> known;
+        std::unordered_map<wxString, onNewObject> other;
+    };
+    Pool m_responses;
+    Pool m_events;
+    Pool m_requests;
+    /// messages are built on the reader thread too (see Client::SetParseOnReaderThread()) while the message
+    /// constructors register their class: the pools are shared
+    mutable std::shared_mutex m_lock;
 
 protected:
-    ProtocolMessage::Ptr_t New(const wxString& name, const std::unordered_map<wxString, onNewObject>& pool);
+    ProtocolMessage::Ptr_t New(const wxString& name, const Pool& pool);
+    ProtocolMessage::Ptr_t New(eMessageName name, const Pool& pool);
+    void Register(const wxString& name, onNewObject func, Pool& pool);
+    void Register(const char* name, onNewObject func, Pool& pool);
 
 public:
     static ObjGenerator& Get();
@@ -185,14 +215,25 @@ public:
      */
     ProtocolMessage::Ptr_t New(const wxString& type, const wxString& name);
 
+    /**
+     * @brief create new request / response / event by name id. Returns nullptr if no class is registered for it
+     */
+    ProtocolMessage::Ptr_t NewRequest(eMessageName name) { return New(name, m_requests); }
+    ProtocolMessage::Ptr_t NewResponse(eMessageName name) { return New(name, m_responses); }
+    ProtocolMessage::Ptr_t NewEvent(eMessageName name) { return New(name, m_events); }
+
     /**
      * @brief create new ProtocolMessage from raw Json object
      */
     ProtocolMessage::Ptr_t FromJSON(Json json);
 
-    void RegisterResponse(const wxString& name, onNewObject func);
-    void RegisterEvent(const wxString& name, onNewObject func);
-    void RegisterRequest(const wxString& name, onNewObject func);
+    // Registering an already registered name is a no-op
+    void RegisterResponse(const wxString& name, onNewObject func) { Register(name, std::move(func), m_responses); }
+    void RegisterEvent(const wxString& name, onNewObject func) { Register(name, std::move(func), m_events); }
+    void RegisterRequest(const wxString& name, onNewObject func) { Register(name, std::move(func), m_requests); }
+    void RegisterResponse(const char* name, onNewObject func) { Register(name, std::move(func), m_responses); }
+    void RegisterEvent(const char* name, onNewObject func) { Register(name, std::move(func), m_events); }
+    void RegisterRequest(const char* name, onNewObject func) { Register(name, std::move(func), m_requests); }
 };
 
 /// A client or debug adapter initiated request
@@ -204,6 +245,9 @@ struct WXDLLIMPEXP_DAP Request : public ProtocolMessage {
     Request() { type = "request"; }
     virtual ~Request() = 0; // force to abstract class
     JSON_SERIALIZE();
+
+protected:
+    void WriteFields(JsonWriter& writer) const;
 };
 
 /// The 'cancel' request is used by the frontend to indicate that it is no
@@ -388,6 +432,7 @@ struct WXDLLIMPEXP_DAP Source : public Any {
 
     ANY_CLASS(Source);
     JSON_SERIALIZE();
+    JSON_WRITE();
 };
 
 /// Information about a Breakpoint created in setBreakpoints or
@@ -710,6 +755,7 @@ struct WXDLLIMPEXP_DAP StepArguments : public Any {
 
     ANY_CLASS(StepArguments);
     JSON_SERIALIZE();
+    JSON_WRITE();
 };
 
 typedef StepArguments StepInArguments;
@@ -859,6 +905,7 @@ struct WXDLLIMPEXP_DAP ContinueArguments : public Any {
 
     ANY_CLASS(ContinueArguments);
     JSON_SERIALIZE();
+    JSON_WRITE();
 };
 
 /// Arguments for the continue request
@@ -872,6 +919,7 @@ struct WXDLLIMPEXP_DAP NextArguments : public Any {
 
     ANY_CLASS(NextArguments);
     JSON_SERIALIZE();
+    JSON_WRITE();
 };
 
 /// The request starts the debuggee to run again.
@@ -879,6 +927,7 @@ struct WXDLLIMPEXP_DAP ContinueRequest : public Request {
     ContinueArguments arguments;
     REQUEST_CLASS(ContinueRequest, "continue");
     JSON_SERIALIZE();
+    JSON_WRITE();
 };
 
 /// Response to 'continue' request.
@@ -893,6 +942,7 @@ struct WXDLLIMPEXP_DAP NextRequest : public Request {
     NextArguments arguments;
     REQUEST_CLASS(NextRequest, "next");
     JSON_SERIALIZE();
+    JSON_WRITE();
 };
 
 /// Response to 'continue' request.
@@ -905,6 +955,7 @@ struct WXDLLIMPEXP_DAP StepRequest : public Request {
     StepArguments arguments;
     REQUEST_CLASS(StepRequest, "step");
     JSON_SERIALIZE();
+    JSON_WRITE();
 };
 
 struct WXDLLIMPEXP_DAP StepInRequest : public StepRequest {
@@ -956,6 +1007,7 @@ struct WXDLLIMPEXP_DAP StackFrame : public Any {
 struct WXDLLIMPEXP_DAP ThreadsRequest : public Request {
     REQUEST_CLASS(ThreadsRequest, "threads");
     JSON_SERIALIZE();
+    JSON_WRITE();
 };
 
 /// A Thread
@@ -1047,6 +1099,7 @@ struct WXDLLIMPEXP_DAP ScopesArguments : public Any {
     int frameId = 0;
     ANY_CLASS(ScopesArguments);
     JSON_SERIALIZE();
+    JSON_WRITE();
 };
 
 /// The request returns the variable scopes for a given stackframe ID.
@@ -1054,6 +1107,7 @@ struct WXDLLIMPEXP_DAP ScopesRequest : public Request {
     ScopesArguments arguments;
     REQUEST_CLASS(ScopesRequest, "scopes");
     JSON_SERIALIZE();
+    JSON_WRITE();
 };
 
 struct WXDLLIMPEXP_DAP Scope : public Any {
@@ -1094,6 +1148,7 @@ struct WXDLLIMPEXP_DAP StackTraceArguments : public Any {
     int levels = 0;
     ANY_CLASS(StackTraceArguments);
     JSON_SERIALIZE();
+    JSON_WRITE();
 };
 
 /// The request returns a stacktrace from the current execution state.
@@ -1101,6 +1156,7 @@ struct WXDLLIMPEXP_DAP StackTraceRequest : public Request {
     StackTraceArguments arguments;
     REQUEST_CLASS(StackTraceRequest, "stackTrace");
     JSON_SERIALIZE();
+    JSON_WRITE();
 };
 
 /// Response to 'stackTrace' request.
@@ -1119,6 +1175,7 @@ struct WXDLLIMPEXP_DAP ValueFormat : public Any {
     bool hex = false;
     ANY_CLASS(ValueFormat);
     JSON_SERIALIZE();
+    JSON_WRITE();
 };
 
 struct WXDLLIMPEXP_DAP VariablesArguments : public Any {
@@ -1130,12 +1187,14 @@ struct WXDLLIMPEXP_DAP VariablesArguments : public Any {
     int count = 0;
     ANY_CLASS(VariablesArguments);
     JSON_SERIALIZE();
+    JSON_WRITE();
 };
 
 struct WXDLLIMPEXP_DAP VariablesRequest : public Request {
     VariablesArguments arguments;
     REQUEST_CLASS(VariablesRequest, "variables");
     JSON_SERIALIZE();
+    JSON_WRITE();
 };
 
 struct WXDLLIMPEXP_DAP VariablesResponse : public Response {
@@ -1157,6 +1216,7 @@ struct WXDLLIMPEXP_DAP PauseArguments : public Any {
     int threadId = 0;
     ANY_CLASS(PauseArguments);
     JSON_SERIALIZE();
+    JSON_WRITE();
 };
 
 struct WXDLLIMPEXP_DAP RunInTerminalRequestArguments : public Any {
@@ -1193,6 +1253,7 @@ struct WXDLLIMPEXP_DAP PauseRequest : public Request {
     PauseArguments arguments;
     REQUEST_CLASS(PauseRequest, "pause");
     JSON_SERIALIZE();
+    JSON_WRITE();
 };
 
 struct WXDLLIMPEXP_DAP PauseResponse : public EmptyAckResponse {
@@ -1214,6 +1275,7 @@ struct WXDLLIMPEXP_DAP SourceArguments : public Any {
     int sourceReference = 0;
     ANY_CLASS(SourceArguments);
     JSON_SERIALIZE();
+    JSON_WRITE();
 };
 
 // source request
@@ -1221,6 +1283,7 @@ struct WXDLLIMPEXP_DAP SourceRequest : public Request {
     SourceArguments arguments;
     REQUEST_CLASS(SourceRequest, "source");
     JSON_SERIALIZE();
+    JSON_WRITE();
 };
 
 // source response
@@ -1273,12 +1336,14 @@ struct WXDLLIMPEXP_DAP EvaluateArguments : public Any {
     ValueFormat format;
     ANY_CLASS(EvaluateArguments);
     JSON_SERIALIZE();
+    JSON_WRITE();
 };
 
 struct WXDLLIMPEXP_DAP EvaluateRequest : public Request {
     EvaluateArguments arguments;
     REQUEST_CLASS(EvaluateRequest, "evaluate");
     JSON_SERIALIZE();
+    JSON_WRITE();
 };
 
 struct WXDLLIMPEXP_DAP EvaluateResponse : public Response {
@@ -1313,6 +1378,20 @@ struct WXDLLIMPEXP_DAP DebugpyWaitingForServerEvent : public Event {
     EVENT_CLASS(DebugpyWaitingForServerEvent, wxEmptyString);
     JSON_SERIALIZE();
 };
+
+/// extension to the protocol: the state of a stopped thread, prefetched by the client when it stops (see
+/// Client::SetPrefetchOnStop())
+struct WXDLLIMPEXP_DAP StopSnapshot : public Any {
+    int threadId = wxNOT_FOUND;
+    std::shared_ptr<StackTraceResponse> stackTrace;
+    /// the scopes of the top frame
+    std::shared_ptr<ScopesResponse> scopes;
+    /// the variables of each scope, in the order of `scopes`. Null for expensive scopes, which are not fetched
+    std::vector<std::shared_ptr<VariablesResponse>> variables;
+
+    ANY_CLASS(StopSnapshot);
+    JSON_SERIALIZE();
+};
 }; // namespace dap
 
 namespace std
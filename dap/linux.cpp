@@ -10,12 +10,14 @@
 
 namespace dap
 {
-Process* ExecuteProcess(const wxString& cmd, const wxString& workingDir)
+Process* ExecuteProcess(const wxString& cmd, const wxString& workingDir, bool startThreads)
 {
     std::vector<wxString> args = DapStringUtils::BuildArgv(cmd);
     LOG_DEBUG() << "Starting process:" << args;
     UnixProcess* process = new UnixProcess(args);
-    process->StartThreads();
+    if (startThreads) {
+        process->StartThreads();
+    }
     process->SetProcessId(process->child_pid);
     return process;
 }
@@ -114,9 +114,11 @@ bool ProcessMSW::DoRead(std::string& ostrout, std::string& ostrerr)
     return !ostrerr.empty() || !ostrout.empty();
 }
 
-Process* ExecuteProcess(const wxString& cmd, const wxString& workingDir)
+Process* ExecuteProcess(const wxString& cmd, const wxString& workingDir, bool startThreads)
 {
     UNUSED(workingDir);
+    // anonymous pipes can't be polled: the reader threads are always used
+    UNUSED(startThreads);
     // Set the bInheritHandle flag so pipe handles are inherited.
     SECURITY_ATTRIBUTES saAttr;
     saAttr.nLength = sizeof(SECURITY_ATTRIBUTES);
@@ -1,8 +1,26 @@
+#include "dap/Client.hpp"
+#include "dap/DAPEvent.hpp"
+#include "dap/Interrupter.hpp"
+#include "dap/SocketClient.hpp"
+#include "dap/SocketServer.hpp"
 #include "dap/JsonRPC.hpp"
+#include "dap/cJSON.hpp"
+#include "dap/JsonWriter.hpp"
+#include "dap/Queue.hpp"
 #include "dap/dap.hpp"
 #include "tester.h"
+#include <chrono>
+#include <csignal>
 #include <cstdio>
 #include <cstdlib>
+#include <future>
+#include <thread>
+#ifndef _WIN32
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 #include <string.h>
 #include <string>
 #include "dap/StringUtils.hpp"
@@ -21,6 +39,119 @@ using namespace std;
     CHECK_CONDITION(obj, str); \
     CHECK_STRING(obj->As<dap::Event>()->event.c_str().AsChar(), str)
 
+namespace
+{
+/// a transport that records the outgoing traffic and never receives anything
+class RecordingTransport : public dap::Transport
+{
+public:
+    std::vector<std::string> m_sent;
+    /// the number of buffers passed to each SendBatch() call
+    std::vector<size_t> m_batches;
+
+    bool Read(std::string& buffer, int) override
+    {
+        buffer.clear();
+        return true;
+    }
+
+    /// when set, nothing is accepted
+    bool m_failSends = false;
+
+    size_t Send(const std::string& buffer) override
+    {
+        if (m_failSends) {
+            return 0;
+        }
+        m_sent.push_back(buffer);
+        return buffer.length();
+    }
+
+    size_t SendBatch(const std::string_view* buffers, size_t count) override
+    {
+        m_batches.push_back(count);
+        return dap::Transport::SendBatch(buffers, count);
+    }
+};
+
+#ifndef _WIN32
+/// a socket transport over an already connected descriptor
+class ConnectedSocketTransport : public dap::SocketTransport
+{
+public:
+    explicit ConnectedSocketTransport(int fd)
+    {
+        delete m_socket;
+        m_socket = new dap::Socket(fd);
+    }
+};
+#endif
+
+/// a process that writes `m_stderrChunks` chunks to stderr, then a single chunk to stdout, read by the Process threads
+class ChattyProcess : public dap::Process
+{
+public:
+    size_t m_stderrChunks = 0;
+    size_t m_reads = 0;
+
+    ~ChattyProcess() override { Cleanup(); }
+    bool Write(const std::string&) override { return true; }
+    bool WriteLn(const std::string&) override { return true; }
+    bool IsAlive() const override { return true; }
+    void Terminate() override {}
+
+protected:
+    bool DoRead(std::string& str, std::string& err_buff) override
+    {
+        ++m_reads;
+        if (m_reads <= m_stderrChunks) {
+            err_buff = "error " + std::to_string(m_reads);
+        } else if (m_reads == m_stderrChunks + 1) {
+            str = "output";
+        } else {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return !str.empty() || !err_buff.empty();
+    }
+};
+
+/// a client that is fed with raw network buffers by the test instead of a reader thread
+class TestClient : public dap::Client
+{
+public:
+    TestClient() { m_transport = new RecordingTransport(); }
+
+    RecordingTransport* GetTransport() { return static_cast<RecordingTransport*>(m_transport); }
+
+    /// deliver `payload` as if it arrived over the network
+    void Receive(const std::string& payload)
+    {
+        OnDataRead("Content-Length: " + std::to_string(payload.size()) + "\r\n\r\n" + payload);
+    }
+
+    /// queue `chunk` the way the reader thread does, without processing it
+    void Enqueue(const std::string& chunk)
+    {
+        dap::ByteBuffer buffer;
+        buffer.Append(chunk);
+        m_incoming.push(std::move(buffer));
+    }
+    void DrainIncoming() { OnDataAvailable(); }
+    bool QueueFromReader(const std::string& chunk, dap::JsonRPC* rpc)
+    {
+        dap::ByteBuffer buffer;
+        buffer.Append(chunk);
+        return QueueIncoming(buffer, rpc);
+    }
+
+    void CompleteHandshake()
+    {
+        Receive("{\"seq\": 1, \"type\": \"response\", \"request_seq\": 1, \"success\": true, "
+                "\"command\": \"initialize\", \"body\": {\"supportsConfigurationDoneRequest\": true}}");
+    }
+};
+} // namespace
+
 int main(int, char**)
 {
     dap::Initialize();
@@ -139,3 +270,1469 @@ TEST_FUNC(Check_Parsing_JSON_RPC_Message)
     CHECK_NUMBER(count, 1);
     return true;
 }
+
+TEST_FUNC(Check_Parsing_Split_JSON_RPC_Messages)
+{
+    std::string network_buffer;
+    for (int i = 0; i < 100; ++i) {
+        std::string payload = "{\"seq\": " + std::to_string(i) + ", \"type\": \"event\", \"event\": \"output\"}";
+        network_buffer += "Content-Length: " + std::to_string(payload.size()) + "\r\n\r\n" + payload;
+    }
+
+    // feed the messages in small chunks, so both the headers and the payloads are split
+    dap::JsonRPC rpc;
+    int count = 0;
+    bool in_order = true;
+    for (size_t offset = 0; offset < network_buffer.size(); offset += 7) {
+        rpc.AppendBuffer(network_buffer.substr(offset, 7));
+        rpc.ProcessBuffer(
+            [&](const dap::Json& json, wxObject*) {
+                in_order = in_order && (json["seq"].GetInteger() == count);
+                ++count;
+            },
+            nullptr);
+    }
+    CHECK_NUMBER(count, 100);
+    CHECK_CONDITION(in_order, "messages were not delivered in order");
+    return true;
+}
+
+TEST_FUNC(Check_JSON_RPC_Headers)
+{
+    const std::string payload = "{\"seq\": 7, \"type\": \"event\", \"event\": \"initialized\"}";
+    std::string network_buffer;
+    // a header section without Content-Length is dropped
+    network_buffer += "Content-Type: application/vscode-jsonrpc\r\n\r\n";
+    // header names are case insensitive and other headers are ignored
+    network_buffer += "Content-Type: application/vscode-jsonrpc; charset=utf-8\r\ncontent-length:  " +
+                      std::to_string(payload.size()) + "\r\n\r\n" + payload;
+
+    dap::JsonRPC rpc;
+    rpc.SetBuffer(network_buffer);
+    int count = 0;
+    int seq = 0;
+    rpc.ProcessBuffer(
+        [&](const dap::Json& json, wxObject*) {
+            seq = json["seq"].GetInteger();
+            ++count;
+        },
+        nullptr);
+    CHECK_NUMBER(count, 1);
+    CHECK_NUMBER(seq, 7);
+    return true;
+}
+
+TEST_FUNC(Check_Arena_Parsed_Messages)
+{
+    std::string network_buffer;
+    for (int i = 0; i < 3; ++i) {
+        std::string payload = "{\"seq\": " + std::to_string(i) +
+                              ", \"type\": \"event\", \"event\": \"output\", \"body\": {\"output\": \"line " +
+                              std::to_string(i) + "\"}}";
+        network_buffer += "Content-Length: " + std::to_string(payload.size()) + "\r\n\r\n" + payload;
+    }
+
+    // keep the first message alive while the others are parsed: its arena must not be recycled under it
+    dap::JsonRPC rpc;
+    rpc.SetBuffer(network_buffer);
+    std::vector<dap::Json> messages;
+    rpc.ProcessBuffer([&](const dap::Json& json, wxObject*) { messages.push_back(json); }, nullptr);
+    CHECK_NUMBER(messages.size(), 3);
+    for (size_t i = 0; i < messages.size(); ++i) {
+        CHECK_NUMBER(messages[i]["seq"].GetInteger(), (int)i);
+        CHECK_STRING(messages[i]["body"]["output"].GetString().c_str().AsChar(),
+                     ("line " + std::to_string(i)).c_str());
+    }
+
+    // arena backed trees are read-only
+    dap::Json body = messages[0]["body"];
+    CHECK_CONDITION(body.IsArenaBacked(), "inbound message is not arena backed");
+    body.Add("category", "stdout");
+    CHECK_CONDITION(!body["category"].IsOK(), "arena backed Json was modified");
+    return true;
+}
+
+TEST_FUNC(Check_Json_Member_Lookup)
+{
+    // enough members to get the object indexed, with a duplicate key: the first occurrence wins
+    std::string payload = "{";
+    for (int i = 0; i < 20; ++i) {
+        payload += "\"field" + std::to_string(i) + "\": " + std::to_string(i) + ", ";
+    }
+    payload += "\"field3\": 100}";
+
+    dap::Json json = dap::Json::Parse(payload.c_str());
+    bool all_found = true;
+    for (int i = 0; i < 20; ++i) {
+        std::string name = "field" + std::to_string(i);
+        all_found = all_found && json[name.c_str()].GetInteger() == i;
+        all_found = all_found && json[wxString(name)].GetInteger() == i;
+    }
+    CHECK_CONDITION(all_found, "indexed lookup failed");
+    CHECK_NUMBER(json["field3"].GetInteger(), 3);
+    CHECK_CONDITION(!json["field"].IsOK(), "found a missing member");
+    CHECK_CONDITION(!json["Field1"].IsOK(), "member lookup is not case sensitive");
+
+    // the parser builds the index, lookups never modify the tree (it may be read from several threads)
+    dap::cJsonDap* tree = dap::cJSON_Parse(payload.c_str());
+    CHECK_CONDITION((tree->index != nullptr), "the parser did not index a large object");
+    CHECK_NUMBER(dap::cJSON_FindObjectItem(tree, "field7", 6)->valueint, 7);
+    dap::cJSON_Delete(tree);
+
+    // modifying an object invalidates its index
+    json.Add("late", 42);
+    CHECK_NUMBER(json["late"].GetInteger(), 42);
+    CHECK_NUMBER(json["field19"].GetInteger(), 19);
+    return true;
+}
+
+TEST_FUNC(Check_Json_String_Views)
+{
+    // parse a buffer that is not NULL terminated: only the first message must be consumed
+    const std::string buffer = "{\"name\": \"caf\xc3\xa9\", \"count\": 3}{\"name\": \"other\"}";
+    std::string_view first(buffer.data(), buffer.find('}') + 1);
+
+    dap::Json json = dap::Json::Parse(first);
+    CHECK_CONDITION(json.IsOK(), "failed to parse a string_view");
+    CHECK_NUMBER(json["count"].GetInteger(), 3);
+    CHECK_CONDITION((json["name"].GetStringView() == "caf\xc3\xa9"), "GetStringView() returned the wrong value");
+    CHECK_CONDITION((json["name"].GetNameView() == "name"), "GetNameView() returned the wrong value");
+    CHECK_CONDITION((json["name"].GetString() == wxString::FromUTF8("caf\xc3\xa9")), "GetString() is not UTF-8");
+    CHECK_CONDITION((json["count"].GetStringView("none") == "none"), "GetStringView() ignored the default value");
+
+    dap::JsonArena::Ptr_t arena(new dap::JsonArena());
+    dap::Json second = dap::Json::Parse(std::string_view(buffer).substr(first.length()), arena.get());
+    CHECK_CONDITION((second["name"].GetStringView() == "other"), "failed to parse a string_view into an arena");
+    return true;
+}
+
+TEST_FUNC(Check_Client_Dispatch)
+{
+    TestClient client;
+    int initialized = 0;
+    client.Bind(wxEVT_DAP_INITIALIZE_RESPONSE, [&](DAPEvent& event) {
+        initialized += event.GetDapResponse() && event.GetDapResponse()->success;
+    });
+    client.CompleteHandshake();
+    CHECK_NUMBER(initialized, 1);
+
+    int frames = 0;
+    int stack_trace_events = 0;
+    client.Bind(wxEVT_DAP_STACKTRACE_RESPONSE, [&](DAPEvent& event) {
+        auto response = event.GetDapResponse()->As<dap::StackTraceResponse>();
+        frames = response ? (int)response->stackFrames.size() : -1;
+        ++stack_trace_events;
+    });
+    client.Receive("{\"seq\": 2, \"type\": \"response\", \"request_seq\": 2, \"success\": true, "
+                   "\"command\": \"stackTrace\", \"body\": {\"stackFrames\": [{\"id\": 1, \"name\": \"main\"}, "
+                   "{\"id\": 2, \"name\": \"start\"}]}}");
+    CHECK_NUMBER(stack_trace_events, 1);
+    CHECK_NUMBER(frames, 2);
+
+    wxString result;
+    client.EvaluateExpression("argc", 1, dap::EvaluateContext::HOVER,
+                              [&](bool success, const wxString& value, const wxString&, int) {
+                                  result = success ? value : "failed";
+                              });
+    CHECK_NUMBER(client.GetTransport()->m_sent.size(), 1);
+    client.Receive("{\"seq\": 3, \"type\": \"response\", \"request_seq\": 1, \"success\": true, "
+                   "\"command\": \"evaluate\", \"body\": {\"result\": \"3\", \"variablesReference\": 0}}");
+    CHECK_STRING(result.c_str().AsChar(), "3");
+    return true;
+}
+
+TEST_FUNC(Check_Client_Pending_Requests)
+{
+    TestClient client;
+    client.CompleteHandshake();
+
+    std::vector<int> scopes;
+    std::vector<int> originating;
+    client.Bind(wxEVT_DAP_SCOPES_RESPONSE, [&](DAPEvent& event) {
+        scopes.push_back(event.GetDapResponse()->As<dap::ScopesResponse>()->refId);
+        originating.push_back(event.GetOriginatingRequest() ? event.GetOriginatingRequest()->seq : -1);
+    });
+    wxString first;
+    wxString second;
+    client.GetScopes(10);
+    client.GetScopes(20);
+    client.EvaluateExpression("a", 1, dap::EvaluateContext::HOVER,
+                              [&](bool, const wxString& value, const wxString&, int) { first = value; });
+    client.EvaluateExpression("b", 1, dap::EvaluateContext::HOVER,
+                              [&](bool, const wxString& value, const wxString&, int) { second = value; });
+    CHECK_SIZE(client.GetTransport()->m_sent.size(), 4);
+
+    // responses arriving out of order are matched with their own request
+    client.Receive("{\"seq\": 2, \"type\": \"response\", \"request_seq\": 4, \"success\": true, "
+                   "\"command\": \"evaluate\", \"body\": {\"result\": \"B\", \"variablesReference\": 0}}");
+    client.Receive("{\"seq\": 3, \"type\": \"response\", \"request_seq\": 2, \"success\": true, "
+                   "\"command\": \"scopes\", \"body\": {\"scopes\": []}}");
+    client.Receive("{\"seq\": 4, \"type\": \"response\", \"request_seq\": 1, \"success\": true, "
+                   "\"command\": \"scopes\", \"body\": {\"scopes\": []}}");
+    CHECK_STRING(first.c_str().AsChar(), "");
+    CHECK_STRING(second.c_str().AsChar(), "B");
+    CHECK_SIZE(scopes.size(), 2);
+    CHECK_NUMBER(scopes[0], 20);
+    CHECK_NUMBER(scopes[1], 10);
+    CHECK_NUMBER(originating[0], 2);
+    CHECK_NUMBER(originating[1], 1);
+
+    // a response is matched once, unknown sequences get no context
+    client.Receive("{\"seq\": 5, \"type\": \"response\", \"request_seq\": 1, \"success\": true, "
+                   "\"command\": \"scopes\", \"body\": {\"scopes\": []}}");
+    CHECK_SIZE(scopes.size(), 3);
+    CHECK_NUMBER(scopes[2], wxNOT_FOUND);
+    CHECK_NUMBER(originating[2], -1);
+
+    client.Receive("{\"seq\": 6, \"type\": \"response\", \"request_seq\": 3, \"success\": true, "
+                   "\"command\": \"evaluate\", \"body\": {\"result\": \"A\", \"variablesReference\": 0}}");
+    CHECK_STRING(first.c_str().AsChar(), "A");
+    return true;
+}
+
+TEST_FUNC(Check_Future)
+{
+    int value = 0;
+    auto promise = std::make_unique<dap::Promise<int>>();
+    dap::Future<int> future = promise->GetFuture();
+    CHECK_CONDITION(!future.IsReady(), "future completed early");
+    future.Then([&](const std::shared_ptr<int>& v) { value = v ? *v : -1; });
+    promise->SetValue(std::make_shared<int>(7));
+    CHECK_CONDITION(future.IsReady(), "future not completed");
+    CHECK_NUMBER(value, 7);
+
+    // chaining: the returned future completes with the result of the inner one
+    dap::Promise<std::string> inner;
+    auto outer = std::make_unique<dap::Promise<int>>();
+    std::string chained;
+    outer->GetFuture()
+        .Then([&](const std::shared_ptr<int>&) { return inner.GetFuture(); })
+        .Then([&](const std::shared_ptr<std::string>& v) { chained = v ? *v : "null"; });
+    outer->SetValue(std::make_shared<int>(1));
+    CHECK_STRING(chained.c_str(), "");
+    inner.SetValue(std::make_shared<std::string>("done"));
+    CHECK_STRING(chained.c_str(), "done");
+
+    // a broken promise completes with null, WhenAll keeps the order
+    std::vector<dap::Future<int>> futures;
+    auto first = std::make_unique<dap::Promise<int>>();
+    auto second = std::make_unique<dap::Promise<int>>();
+    futures.push_back(first->GetFuture());
+    futures.push_back(second->GetFuture());
+    size_t results = 0;
+    bool ordered = false;
+    dap::WhenAll(futures).Then([&](const std::shared_ptr<std::vector<std::shared_ptr<int>>>& all) {
+        results = all->size();
+        ordered = (*all)[0] == nullptr && (*all)[1] && *(*all)[1] == 2;
+    });
+    second->SetValue(std::make_shared<int>(2));
+    CHECK_SIZE(results, 0);
+    first.reset();
+    CHECK_SIZE(results, 2);
+    CHECK_CONDITION(ordered, "unexpected WhenAll results");
+    return true;
+}
+
+TEST_FUNC(Check_Client_Futures)
+{
+    TestClient client;
+    client.CompleteHandshake();
+
+    // scopes -> variables of every scope, without a state machine
+    std::vector<int> references;
+    size_t variables = 0;
+    client.GetScopes(1)
+        .Then([&](const std::shared_ptr<dap::ScopesResponse>& scopes) {
+            std::vector<dap::Future<dap::VariablesResponse>> fetches;
+            for (const auto& scope : scopes->scopes) {
+                fetches.push_back(client.GetChildrenVariables(scope.variablesReference));
+            }
+            return dap::WhenAll(fetches);
+        })
+        .Then([&](const std::shared_ptr<std::vector<std::shared_ptr<dap::VariablesResponse>>>& all) {
+            for (const auto& response : *all) {
+                references.push_back(response->refId);
+                variables += response->variables.size();
+            }
+        });
+    client.Receive("{\"seq\": 2, \"type\": \"response\", \"request_seq\": 1, \"success\": true, "
+                   "\"command\": \"scopes\", \"body\": {\"scopes\": [{\"name\": \"Locals\", "
+                   "\"variablesReference\": 100}, {\"name\": \"Registers\", \"variablesReference\": 200}]}}");
+    CHECK_SIZE(client.GetTransport()->m_sent.size(), 3);
+
+    // both variables requests are in flight, answered out of order
+    client.Receive("{\"seq\": 3, \"type\": \"response\", \"request_seq\": 3, \"success\": true, "
+                   "\"command\": \"variables\", \"body\": {\"variables\": [{\"name\": \"rip\", "
+                   "\"value\": \"0\", \"variablesReference\": 0}]}}");
+    CHECK_SIZE(references.size(), 0);
+    client.Receive("{\"seq\": 4, \"type\": \"response\", \"request_seq\": 2, \"success\": true, "
+                   "\"command\": \"variables\", \"body\": {\"variables\": [{\"name\": \"argc\", "
+                   "\"value\": \"1\", \"variablesReference\": 0}, {\"name\": \"argv\", \"value\": \"0x0\", "
+                   "\"variablesReference\": 0}]}}");
+    CHECK_SIZE(references.size(), 2);
+    CHECK_NUMBER(references[0], 100);
+    CHECK_NUMBER(references[1], 200);
+    CHECK_SIZE(variables, 3);
+
+    // a reset completes the futures of the requests still in flight with a null response
+    bool completed = false;
+    bool null_response = false;
+    client.GetThreads().Then([&](const std::shared_ptr<dap::ThreadsResponse>& response) {
+        completed = true;
+        null_response = response == nullptr;
+    });
+    CHECK_CONDITION(!completed, "threads completed early");
+    client.Reset();
+    CHECK_CONDITION(completed, "reset did not complete the future");
+    CHECK_CONDITION(null_response, "expected a null response");
+
+    // a continuation that sends a request while the client is being reset: the request fails quietly
+    TestClient other;
+    other.CompleteHandshake();
+    int lost_connection = 0;
+    other.Bind(wxEVT_DAP_LOST_CONNECTION, [&](DAPEvent& event) { ++lost_connection; });
+    completed = false;
+    null_response = false;
+    other.GetThreads()
+        .Then([&](const std::shared_ptr<dap::ThreadsResponse>&) { return other.Pause(1); })
+        .Then([&](const std::shared_ptr<dap::PauseResponse>& response) {
+            completed = true;
+            null_response = response == nullptr;
+        });
+    other.Reset();
+    CHECK_CONDITION(completed, "reset did not complete the chained future");
+    CHECK_CONDITION(null_response, "expected a null response");
+    CHECK_NUMBER(lost_connection, 0);
+    return true;
+}
+
+TEST_FUNC(Check_Client_Stop_Snapshot)
+{
+    TestClient client;
+    client.CompleteHandshake();
+    client.SetPrefetchOnStop(true);
+
+    size_t responses = 0;
+    std::vector<std::shared_ptr<dap::StopSnapshot>> snapshots;
+    client.Bind(wxEVT_DAP_STACKTRACE_RESPONSE, [&](DAPEvent& event) { ++responses; });
+    client.Bind(wxEVT_DAP_SCOPES_RESPONSE, [&](DAPEvent& event) { ++responses; });
+    client.Bind(wxEVT_DAP_VARIABLES_RESPONSE, [&](DAPEvent& event) { ++responses; });
+    client.Bind(wxEVT_DAP_STOP_SNAPSHOT, [&](DAPEvent& event) {
+        auto snapshot = dynamic_cast<dap::StopSnapshot*>(event.GetAnyObject());
+        snapshots.push_back(std::make_shared<dap::StopSnapshot>(*snapshot));
+    });
+
+    client.Receive("{\"seq\": 2, \"type\": \"event\", \"event\": \"stopped\", "
+                   "\"body\": {\"reason\": \"breakpoint\", \"threadId\": 7}}");
+    CHECK_SIZE(client.GetTransport()->m_sent.size(), 1);
+    client.Receive("{\"seq\": 3, \"type\": \"response\", \"request_seq\": 1, \"success\": true, "
+                   "\"command\": \"stackTrace\", \"body\": {\"stackFrames\": [{\"id\": 1000, \"name\": \"main\", "
+                   "\"line\": 3, \"column\": 0}]}}");
+    CHECK_SIZE(client.GetTransport()->m_sent.size(), 2);
+
+    // the expensive scope is left for the application to fetch
+    client.Receive("{\"seq\": 4, \"type\": \"response\", \"request_seq\": 2, \"success\": true, "
+                   "\"command\": \"scopes\", \"body\": {\"scopes\": [{\"name\": \"Locals\", "
+                   "\"variablesReference\": 100}, {\"name\": \"Globals\", \"variablesReference\": 200, "
+                   "\"expensive\": true}]}}");
+    CHECK_SIZE(client.GetTransport()->m_sent.size(), 3);
+    CHECK_SIZE(snapshots.size(), 0);
+    client.Receive("{\"seq\": 5, \"type\": \"response\", \"request_seq\": 3, \"success\": true, "
+                   "\"command\": \"variables\", \"body\": {\"variables\": [{\"name\": \"argc\", "
+                   "\"value\": \"1\", \"variablesReference\": 0}]}}");
+    CHECK_SIZE(responses, 0);
+    CHECK_SIZE(snapshots.size(), 1);
+    CHECK_NUMBER(snapshots[0]->threadId, 7);
+    CHECK_SIZE(snapshots[0]->stackTrace->stackFrames.size(), 1);
+    CHECK_SIZE(snapshots[0]->scopes->scopes.size(), 2);
+    CHECK_SIZE(snapshots[0]->variables.size(), 2);
+    CHECK_SIZE(snapshots[0]->variables[0]->variables.size(), 1);
+    CHECK_CONDITION((snapshots[0]->variables[1] == nullptr), "expensive scope was fetched");
+
+    // once the debuggee resumed, the prefetch stops at the next step and no snapshot is delivered
+    client.Receive("{\"seq\": 6, \"type\": \"event\", \"event\": \"stopped\", "
+                   "\"body\": {\"reason\": \"step\", \"threadId\": 7}}");
+    CHECK_SIZE(client.GetTransport()->m_sent.size(), 4);
+    client.Receive("{\"seq\": 7, \"type\": \"event\", \"event\": \"continued\", "
+                   "\"body\": {\"threadId\": 7}}");
+    client.Receive("{\"seq\": 8, \"type\": \"response\", \"request_seq\": 4, \"success\": true, "
+                   "\"command\": \"stackTrace\", \"body\": {\"stackFrames\": [{\"id\": 1001, \"name\": "
+                   "\"main\", \"line\": 4, \"column\": 0}]}}");
+    CHECK_SIZE(client.GetTransport()->m_sent.size(), 4);
+    CHECK_SIZE(snapshots.size(), 1);
+    return true;
+}
+
+TEST_FUNC(Check_Client_Response_Cache)
+{
+    TestClient client;
+    client.CompleteHandshake();
+    client.SetCacheResponses(true);
+
+    std::vector<int> references;
+    client.Bind(wxEVT_DAP_VARIABLES_RESPONSE, [&](DAPEvent& event) {
+        references.push_back(event.GetDapResponse()->As<dap::VariablesResponse>()->refId);
+    });
+    client.Receive("{\"seq\": 2, \"type\": \"event\", \"event\": \"stopped\", "
+                   "\"body\": {\"reason\": \"breakpoint\", \"threadId\": 1}}");
+
+    client.GetChildrenVariables(100);
+    client.Receive("{\"seq\": 3, \"type\": \"response\", \"request_seq\": 1, \"success\": true, "
+                   "\"command\": \"variables\", \"body\": {\"variables\": [{\"name\": \"argc\", "
+                   "\"value\": \"1\", \"variablesReference\": 0}]}}");
+    CHECK_SIZE(references.size(), 1);
+
+    // same arguments: answered right away, without a request
+    auto future = client.GetChildrenVariables(100);
+    CHECK_CONDITION(future.IsReady(), "cached response not delivered");
+    CHECK_SIZE(future.Get()->variables.size(), 1);
+    CHECK_SIZE(references.size(), 2);
+    CHECK_NUMBER(references[1], 100);
+    CHECK_SIZE(client.GetTransport()->m_sent.size(), 1);
+    CHECK_SIZE(client.GetResponseCacheStats().hits, 1);
+    CHECK_SIZE(client.GetResponseCacheStats().misses, 1);
+
+    // a different format is another request
+    client.GetChildrenVariables(100, dap::EvaluateContext::VARIABLES, 10, dap::ValueDisplayFormat::HEX);
+    CHECK_SIZE(client.GetTransport()->m_sent.size(), 2);
+    CHECK_SIZE(client.GetResponseCacheStats().misses, 2);
+
+    // its response arrives after the debuggee resumed: it is delivered but not cached
+    client.Receive("{\"seq\": 4, \"type\": \"event\", \"event\": \"continued\", "
+                   "\"body\": {\"threadId\": 1}}");
+    client.Receive("{\"seq\": 5, \"type\": \"response\", \"request_seq\": 2, \"success\": true, "
+                   "\"command\": \"variables\", \"body\": {\"variables\": []}}");
+    CHECK_SIZE(references.size(), 3);
+    client.Receive("{\"seq\": 6, \"type\": \"event\", \"event\": \"stopped\", "
+                   "\"body\": {\"reason\": \"step\", \"threadId\": 1}}");
+    client.GetChildrenVariables(100, dap::EvaluateContext::VARIABLES, 10, dap::ValueDisplayFormat::HEX);
+    client.GetChildrenVariables(100);
+    CHECK_SIZE(client.GetTransport()->m_sent.size(), 4);
+    CHECK_SIZE(client.GetResponseCacheStats().hits, 1);
+    CHECK_SIZE(client.GetResponseCacheStats().misses, 4);
+
+    client.Reset();
+    CHECK_SIZE(client.GetResponseCacheStats().misses, 0);
+    return true;
+}
+
+TEST_FUNC(Check_Client_Coalesced_Requests)
+{
+    TestClient client;
+    client.CompleteHandshake();
+    client.SetCoalesceRequests(true);
+
+    std::vector<int> references;
+    client.Bind(wxEVT_DAP_VARIABLES_RESPONSE, [&](DAPEvent& event) {
+        references.push_back(event.GetDapResponse()->As<dap::VariablesResponse>()->refId);
+    });
+
+    // the second call of each pair is attached to the first one, except in the REPL context
+    auto first = client.GetChildrenVariables(100);
+    auto second = client.GetChildrenVariables(100);
+    CHECK_SIZE(client.GetTransport()->m_sent.size(), 1);
+    std::vector<wxString> results;
+    auto on_evaluate = [&](bool success, const wxString& result, const wxString& type, int variablesReference) {
+        results.push_back(result);
+    };
+    client.EvaluateExpression("x", 1, dap::EvaluateContext::HOVER, on_evaluate);
+    client.EvaluateExpression("x", 1, dap::EvaluateContext::HOVER, on_evaluate);
+    CHECK_SIZE(client.GetTransport()->m_sent.size(), 2);
+    client.EvaluateExpression("x++", 1, dap::EvaluateContext::REPL, on_evaluate);
+    client.EvaluateExpression("x++", 1, dap::EvaluateContext::REPL, on_evaluate);
+    CHECK_SIZE(client.GetTransport()->m_sent.size(), 4);
+
+    client.Receive("{\"seq\": 2, \"type\": \"response\", \"request_seq\": 1, \"success\": true, "
+                   "\"command\": \"variables\", \"body\": {\"variables\": [{\"name\": \"argc\", "
+                   "\"value\": \"1\", \"variablesReference\": 0}]}}");
+    CHECK_SIZE(references.size(), 2);
+    CHECK_NUMBER(references[1], 100);
+    CHECK_CONDITION(second.IsReady(), "coalesced request not completed");
+    CHECK_CONDITION((first.Get() == second.Get()), "expected the same response");
+
+    client.Receive("{\"seq\": 3, \"type\": \"response\", \"request_seq\": 3, \"success\": true, "
+                   "\"command\": \"evaluate\", \"body\": {\"result\": \"42\", \"variablesReference\": 0}}");
+    CHECK_SIZE(results.size(), 2);
+    CHECK_STRING(results[1].c_str().AsChar(), "42");
+
+    // once answered, the same request is sent again
+    client.GetChildrenVariables(100);
+    CHECK_SIZE(client.GetTransport()->m_sent.size(), 5);
+
+    // not across a resume: the response to the first request describes the previous stop
+    client.GetScopes(1000);
+    client.Receive("{\"seq\": 4, \"type\": \"event\", \"event\": \"continued\", "
+                   "\"body\": {\"threadId\": 1}}");
+    client.GetScopes(1000);
+    CHECK_SIZE(client.GetTransport()->m_sent.size(), 7);
+
+    // off by default: every request is sent
+    TestClient other;
+    other.CompleteHandshake();
+    other.GetChildrenVariables(100);
+    other.GetChildrenVariables(100);
+    CHECK_SIZE(other.GetTransport()->m_sent.size(), 2);
+    return true;
+}
+
+TEST_FUNC(Check_Message_Names)
+{
+    bool round_trip = true;
+    for (size_t i = 1; i < static_cast<size_t>(dap::eMessageName::kCount); ++i) {
+        auto id = static_cast<dap::eMessageName>(i);
+        round_trip = round_trip && dap::FindMessageName(dap::GetMessageName(id)) == id;
+    }
+    CHECK_CONDITION(round_trip, "message name lookup failed");
+    CHECK_CONDITION((dap::FindMessageName("stackTrace") == dap::eMessageName::kStackTrace), "stackTrace not found");
+    CHECK_CONDITION((dap::FindMessageName("stacktrace") == dap::eMessageName::kUnknown), "lookup is not exact");
+    CHECK_CONDITION((dap::FindMessageName("") == dap::eMessageName::kUnknown), "empty name found");
+    static_assert(dap::FindMessageName("stopped") == dap::eMessageName::kStopped, "lookup is not constexpr");
+
+    auto msg = dap::ObjGenerator::Get().NewResponse(dap::eMessageName::kVariables);
+    CHECK_RESPONSE(msg, "variables");
+    return true;
+}
+
+TEST_FUNC(Check_Client_Event_Handlers)
+{
+    TestClient client;
+    client.CompleteHandshake();
+
+    wxString progress;
+    int custom = 0;
+    client.RegisterEventHandler("progressStart",
+                                [&](const dap::Json& json) { progress = json["body"]["title"].GetString(); });
+    client.RegisterEventHandler("myAdapterEvent", [&](const dap::Json&) { ++custom; });
+    client.Receive("{\"seq\": 2, \"type\": \"event\", \"event\": \"progressStart\", "
+                   "\"body\": {\"progressId\": \"1\", \"title\": \"Loading symbols\"}}");
+    client.Receive("{\"seq\": 3, \"type\": \"event\", \"event\": \"myAdapterEvent\"}");
+    CHECK_STRING(progress.c_str().AsChar(), "Loading symbols");
+    CHECK_NUMBER(custom, 1);
+
+    client.RegisterEventHandler("myAdapterEvent", nullptr);
+    client.Receive("{\"seq\": 4, \"type\": \"event\", \"event\": \"myAdapterEvent\"}");
+    CHECK_NUMBER(custom, 1);
+    return true;
+}
+
+TEST_FUNC(Check_Client_Corked_Requests)
+{
+    TestClient client;
+    client.CompleteHandshake();
+
+    // a request sent by an application handler is written right away, even while a batch of messages is dispatched
+    auto transport = client.GetTransport();
+    size_t sent = transport->m_sent.size();
+    std::vector<size_t> sent_before_handler;
+    int next_thread = 1;
+    client.RegisterEventHandler("myAdapterEvent", [&](const dap::Json&) {
+        sent_before_handler.push_back(transport->m_sent.size());
+        client.Pause(next_thread++);
+    });
+    std::string payload = "{\"seq\": 2, \"type\": \"event\", \"event\": \"myAdapterEvent\"}";
+    std::string frame = "Content-Length: " + std::to_string(payload.size()) + "\r\n\r\n" + payload;
+    client.Enqueue(frame + frame);
+    size_t batches = transport->m_batches.size();
+    client.DrainIncoming();
+    CHECK_SIZE(sent_before_handler.size(), 2);
+    CHECK_SIZE(sent_before_handler[1], sent + 1);
+    CHECK_SIZE(transport->m_batches.size(), batches + 2);
+    CHECK_SIZE(transport->m_batches.back(), 1);
+
+    // the variables the client prefetches after a stop, one request per scope, leave in a single write
+    client.SetPrefetchOnStop(true);
+    client.Receive("{\"seq\": 3, \"type\": \"event\", \"event\": \"stopped\", "
+                   "\"body\": {\"reason\": \"breakpoint\", \"threadId\": 7}}");
+    client.Receive("{\"seq\": 4, \"type\": \"response\", \"request_seq\": 3, \"success\": true, "
+                   "\"command\": \"stackTrace\", \"body\": {\"stackFrames\": [{\"id\": 1000, \"name\": \"main\", "
+                   "\"line\": 3, \"column\": 0}]}}");
+    batches = transport->m_batches.size();
+    sent = transport->m_sent.size();
+    client.Receive("{\"seq\": 5, \"type\": \"response\", \"request_seq\": 4, \"success\": true, "
+                   "\"command\": \"scopes\", \"body\": {\"scopes\": [{\"name\": \"Locals\", "
+                   "\"variablesReference\": 100}, {\"name\": \"Registers\", \"variablesReference\": 200}]}}");
+    CHECK_SIZE(transport->m_batches.size(), batches + 1);
+    CHECK_SIZE(transport->m_batches.back(), 2);
+    CHECK_SIZE(transport->m_sent.size(), sent + 2);
+    CHECK_CONDITION((transport->m_sent[sent].find("\"variablesReference\":100") != std::string::npos),
+                    "requests out of order");
+
+    // a transport that does not take the whole batch is a lost connection, the requests are failed
+    int lost_connection = 0;
+    client.Bind(wxEVT_DAP_LOST_CONNECTION, [&](DAPEvent& event) { ++lost_connection; });
+    client.Receive("{\"seq\": 6, \"type\": \"event\", \"event\": \"stopped\", "
+                   "\"body\": {\"reason\": \"step\", \"threadId\": 7}}");
+    client.Receive("{\"seq\": 7, \"type\": \"response\", \"request_seq\": 7, \"success\": true, "
+                   "\"command\": \"stackTrace\", \"body\": {\"stackFrames\": [{\"id\": 1001, \"name\": \"main\", "
+                   "\"line\": 4, \"column\": 0}]}}");
+    std::vector<std::shared_ptr<dap::StopSnapshot>> snapshots;
+    client.Bind(wxEVT_DAP_STOP_SNAPSHOT, [&](DAPEvent& event) { snapshots.emplace_back(); });
+    transport->m_failSends = true;
+    client.Receive("{\"seq\": 8, \"type\": \"response\", \"request_seq\": 8, \"success\": true, "
+                   "\"command\": \"scopes\", \"body\": {\"scopes\": [{\"name\": \"Locals\", "
+                   "\"variablesReference\": 300}, {\"name\": \"Registers\", \"variablesReference\": 400}]}}");
+    CHECK_NUMBER(lost_connection, 1);
+    CHECK_SIZE(snapshots.size(), 0);
+    return true;
+}
+
+TEST_FUNC(Check_Json_Writer)
+{
+    // the streamed output must be byte-identical to the cJSON printer
+    auto compare = [](const dap::ProtocolMessage& msg) {
+        dap::ByteBuffer buffer;
+        dap::JsonWriter writer(buffer);
+        msg.Write(writer);
+        return std::string(buffer.View()) == std::string(msg.To().ToString(false).mb_str(wxConvUTF8).data());
+    };
+
+    dap::EvaluateRequest evaluate;
+    evaluate.seq = 12;
+    evaluate.arguments.expression = "s == \"a\\b\"\t\x01";
+    evaluate.arguments.frameId = 1000;
+    evaluate.arguments.context = "watch";
+    evaluate.arguments.format.hex = true;
+    CHECK_CONDITION(compare(evaluate), "evaluate: JsonWriter output differs from Json::ToString()");
+
+    dap::StackTraceRequest stack_trace;
+    stack_trace.seq = 13;
+    stack_trace.arguments.threadId = 7;
+    stack_trace.arguments.levels = 100;
+    CHECK_CONDITION(compare(stack_trace), "stack_trace: JsonWriter output differs from Json::ToString()");
+
+    dap::SourceRequest source;
+    source.arguments.source.path = "/home/user/src/main.cpp";
+    source.arguments.source.sourceReference = 3;
+    CHECK_CONDITION(compare(source), "source: JsonWriter output differs from Json::ToString()");
+
+    dap::StepInRequest step_in;
+    step_in.arguments.threadId = 2;
+    CHECK_CONDITION(compare(step_in), "step_in: JsonWriter output differs from Json::ToString()");
+
+    // a response does not implement Write(), it goes through the To() fallback
+    dap::StackTraceResponse response;
+    response.request_seq = 13;
+    response.success = true;
+    dap::StackFrame frame;
+    frame.id = 1;
+    frame.name = "main";
+    frame.line = 42;
+    response.stackFrames.push_back(frame);
+    CHECK_CONDITION(compare(response), "response: JsonWriter output differs from Json::ToString()");
+
+    // Serialize() adds the header in front of the payload
+    dap::JsonRPC rpc;
+    wxString payload = stack_trace.To().ToString(false);
+    wxString expected;
+    expected << "Content-Length: " << payload.length() << "\r\n\r\n" << payload;
+    CHECK_STRING(std::string(rpc.Serialize(stack_trace)).c_str(), expected.mb_str(wxConvUTF8).data());
+    CHECK_STRING(std::string(rpc.Serialize(stack_trace)).c_str(), expected.mb_str(wxConvUTF8).data());
+    return true;
+}
+
+namespace
+{
+/// a copy of `item` with every value replaced by a non default one, so a field that `Write()` misses shows up
+dap::cJsonDap* FillValues(const dap::cJsonDap* item)
+{
+    switch (item->type & 0xFF) {
+    case cJsonDap_False:
+    case cJsonDap_True:
+        return dap::cJSON_CreateTrue();
+    case cJsonDap_Number:
+        return dap::cJSON_CreateNumber(7);
+    case cJsonDap_String:
+        return dap::cJSON_CreateString("a \"b\"\t\\c");
+    case cJsonDap_Array:
+    case cJsonDap_Object: {
+        bool is_array = (item->type & 0xFF) == cJsonDap_Array;
+        dap::cJsonDap* copy = is_array ? dap::cJSON_CreateArray() : dap::cJSON_CreateObject();
+        for (const dap::cJsonDap* child = item->child; child; child = child->next) {
+            if (is_array) {
+                dap::cJSON_AddItemToArray(copy, FillValues(child));
+            } else {
+                dap::cJSON_AddItemToObject(copy, child->string, FillValues(child));
+            }
+        }
+        return copy;
+    }
+    default:
+        return dap::cJSON_CreateNull();
+    }
+}
+} // namespace
+
+TEST_FUNC(Check_Json_Writer_All_Messages)
+{
+    // Write() is hand written next to To(): both must produce the same output for every registered message, with
+    // the default values and with every field set
+    auto matches = [](const dap::ProtocolMessage& msg) {
+        dap::ByteBuffer buffer;
+        dap::JsonWriter writer(buffer);
+        msg.Write(writer);
+        return std::string(buffer.View()) == std::string(msg.To().ToString(false).mb_str(wxConvUTF8).data());
+    };
+
+    std::string mismatches;
+    size_t checked = 0;
+    for (size_t i = 1; i < static_cast<size_t>(dap::eMessageName::kCount); ++i) {
+        auto id = static_cast<dap::eMessageName>(i);
+        for (auto msg : { dap::ObjGenerator::Get().NewRequest(id), dap::ObjGenerator::Get().NewResponse(id),
+                          dap::ObjGenerator::Get().NewEvent(id) }) {
+            if (!msg) {
+                continue;
+            }
+            ++checked;
+            bool ok = matches(*msg);
+
+            dap::cJsonDap* defaults = dap::cJSON_Parse(msg->To().ToString(false).mb_str(wxConvUTF8).data());
+            dap::cJsonDap* filled = FillValues(defaults);
+            char* text = dap::cJSON_PrintUnformatted(filled);
+            msg->From(dap::Json::Parse(text));
+            free(text);
+            dap::cJSON_Delete(filled);
+            dap::cJSON_Delete(defaults);
+            ok = ok && matches(*msg);
+
+            if (!ok) {
+                mismatches += " " + std::string(dap::GetMessageName(id));
+            }
+        }
+    }
+    CHECK_CONDITION((checked > 0), "no message registered");
+    CHECK_CONDITION(mismatches.empty(), ("Write() differs from To() for:" + mismatches).c_str());
+    return true;
+}
+
+TEST_FUNC(Check_SPSC_Queue)
+{
+    constexpr int count = 100000;
+    dap::SPSCQueue<std::string> queue;
+    std::thread producer([&queue]() {
+        for (int i = 0; i < count; ++i) {
+            queue.push(std::to_string(i));
+        }
+    });
+
+    // items must come out complete and in order
+    int expected = 0;
+    std::string item;
+    while (expected < count) {
+        if (!queue.pop(item)) {
+            std::this_thread::yield();
+            continue;
+        }
+        if (item != std::to_string(expected)) {
+            break;
+        }
+        ++expected;
+    }
+    producer.join();
+    CHECK_NUMBER(expected, count);
+    CHECK_CONDITION(queue.empty(), "queue should be empty");
+    return true;
+}
+
+TEST_FUNC(Check_Queue)
+{
+    dap::Queue<std::string> queue(8);
+    CHECK_CONDITION(queue.empty(), "new queue should be empty");
+
+    // bounded: try_push() fails when full and leaves the item untouched
+    for (int i = 0; i < 8; ++i) {
+        CHECK_CONDITION(queue.try_push(std::to_string(i)), "push failed");
+    }
+    std::string extra = "extra";
+    CHECK_CONDITION(!queue.try_push(std::move(extra)), "push into a full queue should fail");
+    CHECK_STRING(extra.c_str(), "extra");
+
+    std::vector<std::string> items;
+    CHECK_SIZE(queue.pop_all(items), 8);
+    CHECK_STRING(items[7].c_str(), "7");
+    CHECK_CONDITION(!queue.pop(std::chrono::milliseconds(1)).has_value(), "pop from an empty queue");
+
+    // several producers, a blocked consumer: everything arrives, in order per producer
+    constexpr int producers = 4;
+    constexpr int count = 20000;
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&queue, p]() {
+            for (int i = 0; i < count; ++i) {
+                queue.push(std::to_string(p) + ":" + std::to_string(i));
+            }
+        });
+    }
+    std::vector<int> next(producers, 0);
+    int received = 0;
+    bool ordered = true;
+    while (received < producers * count) {
+        auto item = queue.pop(std::chrono::milliseconds(1000));
+        if (!item.has_value()) {
+            break;
+        }
+        int p = std::stoi(*item);
+        int i = std::stoi(item->substr(item->find(':') + 1));
+        ordered = ordered && (i == next[p]);
+        next[p] = i + 1;
+        ++received;
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    CHECK_NUMBER(received, producers * count);
+    CHECK_CONDITION(ordered, "items of a producer were reordered");
+
+    // a producer sleeping on a full queue is woken up by a pop, and by close()
+    dap::Queue<int> small(2);
+    CHECK_CONDITION((small.push(1) && small.push(2)), "push failed");
+    std::atomic_bool pushed{ false };
+    std::thread producer([&]() { pushed = small.push(3); });
+    int value = 0;
+    CHECK_CONDITION(small.try_pop(value), "pop failed");
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (!pushed && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::yield();
+    }
+    producer.join();
+    CHECK_CONDITION(pushed, "a pop did not wake up the producer");
+    std::thread blocked([&]() { pushed = small.push(4); });
+    small.close();
+    blocked.join();
+    CHECK_CONDITION(!pushed, "push into a closed queue should fail");
+
+    // closing wakes up a waiting consumer
+    auto consumer =
+        std::async(std::launch::async, [&queue]() { return queue.pop(std::chrono::milliseconds(5000)).has_value(); });
+    CHECK_CONDITION((consumer.wait_for(std::chrono::milliseconds(20)) == std::future_status::timeout),
+                    "pop from an empty queue returned early");
+    queue.close();
+    CHECK_CONDITION((consumer.wait_for(std::chrono::seconds(2)) == std::future_status::ready),
+                    "close() did not wake up");
+    CHECK_CONDITION(!consumer.get(), "pop from a closed queue");
+    CHECK_CONDITION(!queue.push("late"), "push into a closed queue should fail");
+    return true;
+}
+
+TEST_FUNC(Check_Process_Stderr_Flood)
+{
+    // far more stderr than the queue holds before the first stdout message: stdout must still get through, with the
+    // latest stderr output
+    ChattyProcess process;
+    process.m_stderrChunks = 5000;
+    process.StartThreads();
+    auto output = process.ReadStdout(10000);
+    CHECK_CONDITION(output.has_value(), "stdout was not delivered");
+    CHECK_STRING(output->c_str(), "output");
+    std::string last;
+    while (auto err = process.ReadStderr(0)) {
+        last = *err;
+    }
+    CHECK_STRING(last.c_str(), "error 5000");
+    return true;
+}
+
+TEST_FUNC(Check_Client_Coalesced_Reads)
+{
+    TestClient client;
+    client.CompleteHandshake();
+
+    std::vector<wxString> output;
+    client.Bind(wxEVT_DAP_OUTPUT_EVENT, [&](DAPEvent& event) {
+        output.push_back(event.GetDapEvent()->As<dap::OutputEvent>()->output);
+    });
+
+    // two messages split over several reads are all dispatched by a single drain
+    std::string first = "{\"seq\": 2, \"type\": \"event\", \"event\": \"output\", \"body\": {\"output\": \"one\"}}";
+    std::string second = "{\"seq\": 3, \"type\": \"event\", \"event\": \"output\", \"body\": {\"output\": \"two\"}}";
+    std::string stream = "Content-Length: " + std::to_string(first.size()) + "\r\n\r\n" + first +
+                         "Content-Length: " + std::to_string(second.size()) + "\r\n\r\n" + second;
+    client.Enqueue(stream.substr(0, 10));
+    client.Enqueue(stream.substr(10, 50));
+    client.Enqueue(stream.substr(60));
+    CHECK_SIZE(output.size(), 0);
+
+    client.DrainIncoming();
+    CHECK_SIZE(output.size(), 2);
+    CHECK_STRING(output[1].c_str().AsChar(), "two");
+
+    // a wakeup with nothing queued is harmless
+    client.DrainIncoming();
+    CHECK_SIZE(output.size(), 2);
+    return true;
+}
+
+TEST_FUNC(Check_Client_Parse_On_Reader_Thread)
+{
+    TestClient client;
+    client.SetParseOnReaderThread(true);
+    client.CompleteHandshake();
+
+    int frames = 0;
+    std::vector<wxString> output;
+    client.Bind(wxEVT_DAP_STACKTRACE_RESPONSE, [&](DAPEvent& event) {
+        auto response = event.GetDapResponse()->As<dap::StackTraceResponse>();
+        frames = response ? (int)response->stackFrames.size() : -1;
+    });
+    client.Bind(wxEVT_DAP_OUTPUT_EVENT, [&](DAPEvent& event) {
+        output.push_back(event.GetDapEvent()->As<dap::OutputEvent>()->output);
+    });
+    int custom = 0;
+    client.RegisterEventHandler("myAdapterEvent", [&](const dap::Json& json) { custom += json["seq"].GetInteger(); });
+
+    std::vector<std::string> payloads = {
+        "{\"seq\": 2, \"type\": \"response\", \"request_seq\": 2, \"success\": true, \"command\": \"stackTrace\", "
+        "\"body\": {\"stackFrames\": [{\"id\": 1, \"name\": \"main\"}, {\"id\": 2, \"name\": \"start\"}]}}",
+        "{\"seq\": 3, \"type\": \"event\", \"event\": \"output\", \"body\": {\"output\": \"hello\"}}",
+        "{\"seq\": 4, \"type\": \"event\", \"event\": \"myAdapterEvent\"}",
+    };
+    std::string stream;
+    for (const auto& payload : payloads) {
+        stream += "Content-Length: " + std::to_string(payload.size()) + "\r\n\r\n" + payload;
+    }
+
+    // framing, parsing and deserialization happen on the "reader" thread, in small reads
+    std::thread reader([&]() {
+        dap::JsonRPC rpc;
+        for (size_t offset = 0; offset < stream.size(); offset += 7) {
+            client.QueueFromReader(stream.substr(offset, 7), &rpc);
+        }
+    });
+    reader.join();
+    CHECK_NUMBER(frames, 0);
+
+    client.DrainIncoming();
+    CHECK_NUMBER(frames, 2);
+    CHECK_SIZE(output.size(), 1);
+    CHECK_STRING(output[0].c_str().AsChar(), "hello");
+    CHECK_NUMBER(custom, 4);
+    return true;
+}
+
+TEST_FUNC(Check_Client_Parse_On_Reader_Thread_Concurrent)
+{
+    // the reader thread parses and deserializes while the main thread dispatches, releases the trees and builds
+    // messages of its own (which registers their classes)
+    TestClient client;
+    client.SetParseOnReaderThread(true);
+    client.CompleteHandshake();
+
+    size_t outputs = 0;
+    client.Bind(wxEVT_DAP_OUTPUT_EVENT, [&](DAPEvent& event) { ++outputs; });
+
+    const size_t count = 2000;
+    std::string payload = "{\"seq\": 2, \"type\": \"event\", \"event\": \"output\", \"body\": {\"output\": "
+                          "\"hello\", \"category\": \"stdout\", \"a\": 1, \"b\": 2, \"c\": 3, \"d\": 4, \"e\": 5, "
+                          "\"f\": 6, \"g\": 7}}";
+    std::string frame = "Content-Length: " + std::to_string(payload.size()) + "\r\n\r\n" + payload;
+    std::thread reader([&]() {
+        dap::JsonRPC rpc;
+        for (size_t i = 0; i < count; ++i) {
+            client.QueueFromReader(frame, &rpc);
+        }
+    });
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (outputs < count && std::chrono::steady_clock::now() < deadline) {
+        client.DrainIncoming();
+        dap::DebugpyWaitingForServerEvent unregistered_name;
+        dap::OutputEvent known_name;
+    }
+    reader.join();
+    CHECK_SIZE(outputs, count);
+    return true;
+}
+
+#ifndef _WIN32
+TEST_FUNC(Check_Interruptible_Read)
+{
+    int fds[2];
+    CHECK_CONDITION((::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0), "socketpair failed");
+    dap::Socket socket(fds[0]);
+    dap::Socket peer(fds[1]);
+    dap::Interrupter interrupter;
+
+    // an idle wait blocks until the interrupter is signalled from another thread
+    auto waiter = std::async(std::launch::async, [&]() { return socket.SelectReadMS(-1, interrupter); });
+    CHECK_CONDITION((waiter.wait_for(std::chrono::milliseconds(20)) == std::future_status::timeout),
+                    "idle wait returned early");
+    interrupter.Signal();
+    CHECK_CONDITION((waiter.wait_for(std::chrono::seconds(5)) == std::future_status::ready),
+                    "the signal did not wake up the wait");
+    CHECK_NUMBER(waiter.get(), dap::Socket::kInterrupted);
+
+    // the signal stays pending until cleared
+    CHECK_NUMBER(socket.SelectReadMS(0, interrupter), dap::Socket::kInterrupted);
+    interrupter.Clear();
+    CHECK_NUMBER(socket.SelectReadMS(0, interrupter), dap::Socket::kTimeout);
+
+    peer.Send("ping");
+    CHECK_NUMBER(socket.SelectReadMS(-1, interrupter), dap::Socket::kSuccess);
+    std::string content;
+    CHECK_NUMBER(socket.Read(content), dap::Socket::kSuccess);
+    CHECK_STRING(content.c_str(), "ping");
+    return true;
+}
+
+TEST_FUNC(Check_Socket_High_Descriptor)
+{
+    // descriptors above FD_SETSIZE (1024) can not be used with select()
+    constexpr int high_fd = 2000;
+    struct rlimit limit;
+    if (::getrlimit(RLIMIT_NOFILE, &limit) != 0 || limit.rlim_max <= high_fd) {
+        return true; // can't test here
+    }
+    if (limit.rlim_cur <= high_fd) {
+        limit.rlim_cur = high_fd + 1;
+        ::setrlimit(RLIMIT_NOFILE, &limit);
+    }
+
+    int fds[2];
+    CHECK_CONDITION((::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0), "socketpair failed");
+    CHECK_CONDITION((::dup2(fds[0], high_fd) == high_fd), "dup2 failed");
+    ::close(fds[0]);
+    dap::Socket socket(high_fd);
+    dap::Socket peer(fds[1]);
+
+    CHECK_NUMBER(socket.SelectReadMS(10), dap::Socket::kTimeout);
+    CHECK_NUMBER(socket.SelectWriteMS(10), dap::Socket::kSuccess);
+    peer.Send("pong");
+    CHECK_NUMBER(socket.SelectReadMS(1000), dap::Socket::kSuccess);
+    std::string content;
+    CHECK_NUMBER(socket.Read(content), dap::Socket::kSuccess);
+    CHECK_STRING(content.c_str(), "pong");
+    return true;
+}
+
+TEST_FUNC(Check_Socket_Send_Queue)
+{
+    int fds[2];
+    CHECK_CONDITION((::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0), "socketpair failed");
+    ConnectedSocketTransport transport(fds[0]);
+    dap::Socket peer(fds[1]);
+
+    size_t high_water = 0;
+    int high_water_calls = 0;
+    transport.SetHighWaterMark(1 << 20, [&](size_t pending) {
+        high_water = pending;
+        ++high_water_calls;
+    });
+
+    // the peer does not read: Send() must queue instead of blocking
+    std::string chunk(256 << 10, 'a');
+    size_t total = 0;
+    for (int i = 0; i < 32; ++i) {
+        chunk[0] = 'A' + i;
+        CHECK_SIZE(transport.Send(chunk), chunk.size());
+        total += chunk.size();
+    }
+    CHECK_CONDITION((transport.GetPendingBytes() > 0), "nothing was queued");
+    CHECK_NUMBER(high_water_calls, 1);
+    CHECK_CONDITION((high_water > (1 << 20)), "high-water callback called too early");
+
+    // the reader side drains the queue as the peer reads, in order
+    std::string received;
+    std::thread reader([&]() {
+        while (received.size() < total) {
+            if (peer.SelectReadMS(1000) != dap::Socket::kSuccess) {
+                break;
+            }
+            std::string content;
+            peer.Read(content);
+            received += content;
+        }
+    });
+    dap::ByteBuffer incoming;
+    while (transport.GetPendingBytes()) {
+        CHECK_CONDITION(transport.Read(incoming, 100), "read failed");
+    }
+    reader.join();
+    CHECK_SIZE(received.size(), total);
+    for (int i = 0; i < 32; ++i) {
+        CHECK_NUMBER(received[i * chunk.size()], 'A' + i);
+    }
+    CHECK_SIZE(incoming.ReadableBytes(), 0);
+    return true;
+}
+
+TEST_FUNC(Check_Unix_Domain_Socket)
+{
+    std::string path = "/tmp/dap-test-" + std::to_string(::getpid()) + ".sock";
+    std::string connection_string = "unix://" + path;
+    dap::SocketServer server;
+    CHECK_NUMBER(server.Start(connection_string), 0);
+
+    dap::SocketTransport transport;
+    CHECK_CONDITION(transport.Connect(connection_string, 1), "failed to connect");
+    dap::Socket::Ptr_t conn = server.WaitForNewConnection(1);
+    CHECK_CONDITION((conn != nullptr), "no connection accepted");
+
+    CHECK_SIZE(transport.Send("hello"), 5);
+    CHECK_NUMBER(conn->SelectReadMS(1000), dap::Socket::kSuccess);
+    std::string content;
+    CHECK_NUMBER(conn->Read(content), dap::Socket::kSuccess);
+    CHECK_STRING(content.c_str(), "hello");
+
+    // pass a descriptor over the connection, through the transport send queue
+    int pipe_fds[2];
+    CHECK_CONDITION((::pipe(pipe_fds) == 0), "pipe failed");
+    CHECK_SIZE(transport.SendWithDescriptors("fd", { pipe_fds[1] }), 2);
+    ::close(pipe_fds[1]);
+
+    std::vector<int> received;
+    CHECK_NUMBER(conn->SelectReadMS(1000), dap::Socket::kSuccess);
+    CHECK_NUMBER(conn->ReadWithDescriptors(content, received), dap::Socket::kSuccess);
+    CHECK_STRING(content.c_str(), "fd");
+    CHECK_SIZE(received.size(), 1);
+    CHECK_CONDITION((::write(received[0], "x", 1) == 1), "write to the received descriptor failed");
+    ::close(received[0]);
+    char ch = 0;
+    CHECK_CONDITION((::read(pipe_fds[0], &ch, 1) == 1 && ch == 'x'), "data written to the descriptor was not received");
+    ::close(pipe_fds[0]);
+
+    // a path that exists and is not a socket is never removed
+    std::string file_path = "/tmp/dap-test-" + std::to_string(::getpid()) + ".file";
+    FILE* fp = ::fopen(file_path.c_str(), "w");
+    CHECK_CONDITION((fp != nullptr), "failed to create file");
+    ::fclose(fp);
+    bool refused = false;
+    try {
+        dap::SocketServer other;
+        other.Start("unix://" + file_path);
+    } catch (dap::Exception&) {
+        refused = true;
+    }
+    CHECK_CONDITION(refused, "a regular file was replaced by a socket");
+    struct stat st;
+    CHECK_CONDITION((::lstat(file_path.c_str(), &st) == 0 && S_ISREG(st.st_mode)), "the regular file was removed");
+    ::unlink(file_path.c_str());
+    return true;
+}
+
+TEST_FUNC(Check_Socket_Send_Descriptors_Queued)
+{
+    int fds[2];
+    CHECK_CONDITION((::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0), "socketpair failed");
+    ConnectedSocketTransport transport(fds[0]);
+    dap::Socket peer(fds[1]);
+
+    // fill the socket so that the descriptor has to wait in the queue behind the data
+    std::string chunk(1 << 20, 'a');
+    CHECK_SIZE(transport.Send(chunk), chunk.size());
+    CHECK_CONDITION((transport.GetPendingBytes() > 0), "nothing was queued");
+
+    int pipe_fds[2];
+    CHECK_CONDITION((::pipe(pipe_fds) == 0), "pipe failed");
+    CHECK_SIZE(transport.SendWithDescriptors("fd", { pipe_fds[1] }), 2);
+    // the transport owns a duplicate
+    ::close(pipe_fds[1]);
+
+    std::string received;
+    std::vector<int> received_fds;
+    std::thread reader([&]() {
+        while (received.size() < chunk.size() + 2) {
+            if (peer.SelectReadMS(1000) != dap::Socket::kSuccess) {
+                break;
+            }
+            std::string content;
+            peer.ReadWithDescriptors(content, received_fds);
+            received += content;
+        }
+    });
+    dap::ByteBuffer incoming;
+    while (transport.GetPendingBytes()) {
+        CHECK_CONDITION(transport.Read(incoming, 100), "read failed");
+    }
+    reader.join();
+    CHECK_SIZE(received.size(), chunk.size() + 2);
+    CHECK_STRING(received.substr(chunk.size()).c_str(), "fd");
+    CHECK_SIZE(received_fds.size(), 1);
+    CHECK_CONDITION((::write(received_fds[0], "x", 1) == 1), "write to the received descriptor failed");
+    ::close(received_fds[0]);
+    char ch = 0;
+    CHECK_CONDITION((::read(pipe_fds[0], &ch, 1) == 1 && ch == 'x'), "data written to the descriptor was not received");
+
+    // the blocking variant gives up when the peer does not read
+    int other[2];
+    CHECK_CONDITION((::socketpair(AF_UNIX, SOCK_STREAM, 0, other) == 0), "socketpair failed");
+    dap::Socket sender(other[0]);
+    dap::Socket receiver(other[1]);
+    bool timed_out = false;
+    try {
+        sender.SendWithDescriptors(std::string(8 << 20, 'b'), { pipe_fds[0] }, 100);
+    } catch (dap::Exception&) {
+        timed_out = true;
+    }
+    CHECK_CONDITION(timed_out, "SendWithDescriptors did not time out");
+    ::close(pipe_fds[0]);
+    return true;
+}
+
+TEST_FUNC(Check_Socket_Too_Many_Descriptors)
+{
+    int fds[2];
+    CHECK_CONDITION((::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0), "socketpair failed");
+    dap::Socket receiver(fds[1]);
+
+    // more descriptors than the receiver has room for, sent with a raw sendmsg()
+    constexpr size_t count = dap::Socket::kMaxDescriptors + 4;
+    std::vector<int> sent(count, fds[0]);
+    char byte = 'x';
+    iovec iov = { &byte, 1 };
+    std::vector<char> control(CMSG_SPACE(sizeof(int) * count));
+    msghdr msg = {};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.data();
+    msg.msg_controllen = control.size();
+    cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int) * count);
+    memcpy(CMSG_DATA(cmsg), sent.data(), sizeof(int) * count);
+    CHECK_CONDITION((::sendmsg(fds[0], &msg, 0) == 1), "sendmsg failed");
+
+    std::string content;
+    std::vector<int> received;
+    bool truncated = false;
+    try {
+        receiver.ReadWithDescriptors(content, received);
+    } catch (dap::Exception&) {
+        truncated = true;
+    }
+    CHECK_CONDITION(truncated, "truncated descriptors were not reported");
+    CHECK_SIZE(received.size(), 0);
+    ::close(fds[0]);
+    return true;
+}
+
+TEST_FUNC(Check_Stdout_Transport_Pipes)
+{
+    dap::StdoutTransport transport;
+    CHECK_CONDITION(transport.Execute({ "cat" }), "failed to start cat");
+    CHECK_CONDITION(transport.IsInterruptible(), "the pipes should be polled directly");
+
+    CHECK_SIZE(transport.Send("ping\n"), 5);
+    dap::ByteBuffer buffer;
+    for (int i = 0; i < 100 && buffer.ReadableBytes() < 5; ++i) {
+        CHECK_CONDITION(transport.Read(buffer, 100), "read failed");
+    }
+    CHECK_CONDITION((buffer.View() == "ping\n"), "unexpected output");
+
+    // an idle read blocks until interrupted
+    auto reader = std::async(std::launch::async, [&]() { return transport.Read(buffer, -1); });
+    CHECK_CONDITION((reader.wait_for(std::chrono::milliseconds(20)) == std::future_status::timeout),
+                    "idle read returned early");
+    transport.Interrupt();
+    CHECK_CONDITION((reader.wait_for(std::chrono::seconds(5)) == std::future_status::ready),
+                    "Interrupt() did not wake up the read");
+    CHECK_CONDITION(reader.get(), "interrupted read failed");
+
+    // output with embedded NULs is kept intact, the end of the output is reported as an error
+    dap::StdoutTransport printer;
+    CHECK_CONDITION(printer.Execute({ "printf", "a\\000b" }), "failed to start printf");
+    dap::ByteBuffer output;
+    bool alive = true;
+    for (int i = 0; i < 100 && alive; ++i) {
+        alive = printer.Read(output, 100);
+    }
+    CHECK_CONDITION(!alive, "EOF was not reported");
+    CHECK_SIZE(output.ReadableBytes(), 3);
+    CHECK_CONDITION((output.View() == std::string_view("a\0b", 3)), "unexpected output");
+    return true;
+}
+
+TEST_FUNC(Check_Process_Exit_Notification)
+{
+    // the exit status is collected as soon as the exit descriptor fires
+    std::unique_ptr<dap::Process> process(dap::ExecuteProcess("sh -c \"exit 3\"", ".", false));
+    if (process->GetExitFd() != -1) {
+        pollfd pfd = {};
+        pfd.fd = process->GetExitFd();
+        pfd.events = POLLIN;
+        CHECK_NUMBER(dap::Socket::Poll(&pfd, 1, 5000), 1);
+    }
+    for (int i = 0; i < 500 && process->IsAlive(); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    CHECK_CONDITION(!process->IsAlive(), "process should be reaped");
+    CHECK_NUMBER(process->GetExitCode(), 3);
+
+    // killed by a signal
+    std::unique_ptr<dap::Process> sleeper(dap::ExecuteProcess("sleep 10", ".", false));
+    CHECK_CONDITION(sleeper->IsAlive(), "sleep exited early");
+    CHECK_NUMBER(sleeper->GetExitCode(), -1);
+    sleeper->Terminate();
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (sleeper->IsAlive() && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    CHECK_NUMBER(sleeper->GetExitCode(), 128 + SIGTERM);
+
+    // deleting a process that ignores SIGTERM does not wait for it, it is killed in the background
+    std::unique_ptr<dap::Process> stubborn(
+        dap::ExecuteProcess("sh -c \"trap : TERM; echo ready; sleep 3\"", ".", false));
+    int pid = stubborn->GetProcessId();
+    pollfd ready = {};
+    ready.fd = stubborn->GetStdoutFd();
+    ready.events = POLLIN;
+    CHECK_NUMBER(dap::Socket::Poll(&ready, 1, 5000), 1);
+    auto deleted = std::chrono::steady_clock::now();
+    stubborn.reset();
+    CHECK_CONDITION((std::chrono::steady_clock::now() - deleted < std::chrono::milliseconds(500)),
+                    "deleting the process blocked");
+    deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (::kill(pid, 0) == 0 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    CHECK_CONDITION((::kill(pid, 0) == -1), "the process was not killed and reaped");
+
+    // the adapter exits while a child of its own keeps stdout open: the exit is still reported
+    dap::StdoutTransport transport;
+    CHECK_CONDITION(transport.Execute({ "sh", "-c", "sleep 2 & exit 0" }), "failed to start sh");
+    auto start = std::chrono::steady_clock::now();
+    dap::ByteBuffer buffer;
+    bool alive = true;
+    while (alive && std::chrono::steady_clock::now() - start < std::chrono::seconds(5)) {
+        alive = transport.Read(buffer, 100);
+    }
+    CHECK_CONDITION(!alive, "exit was not reported");
+    if (process->GetExitFd() != -1) {
+        CHECK_CONDITION((std::chrono::steady_clock::now() - start < std::chrono::seconds(1)),
+                        "exit was reported only when the pipe closed");
+    }
+    return true;
+}
+
+TEST_FUNC(Check_Process_Write_Full_Pipe)
+{
+    // the adapter never reads its stdin: a write larger than the pipe must give up once the process goes away,
+    // instead of blocking forever
+    std::unique_ptr<dap::Process> process(dap::ExecuteProcess("sleep 10", ".", false));
+    CHECK_CONDITION(process->IsAlive(), "sleep exited early");
+    auto writer = std::async(std::launch::async, [&]() { return process->Write(std::string(4 << 20, 'x')); });
+    CHECK_CONDITION((writer.wait_for(std::chrono::milliseconds(200)) == std::future_status::timeout),
+                    "write to a full pipe returned early");
+    process->Terminate();
+    CHECK_CONDITION((writer.wait_for(std::chrono::seconds(5)) == std::future_status::ready),
+                    "write did not give up");
+    CHECK_CONDITION(!writer.get(), "write to a full pipe succeeded");
+
+    // the adapter exits while a child of its own keeps the pipe open without reading it
+    std::unique_ptr<dap::Process> orphaning(dap::ExecuteProcess("sh -c \"sleep 3 <&0 & exit 0\"", ".", false));
+    if (orphaning->GetExitFd() != -1) {
+        auto start = std::chrono::steady_clock::now();
+        bool written = orphaning->Write(std::string(4 << 20, 'x'));
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        CHECK_CONDITION(!written, "write to a full pipe succeeded");
+        CHECK_CONDITION((elapsed < std::chrono::seconds(2)), "write did not give up when the process exited");
+    }
+    return true;
+}
+
+TEST_FUNC(Check_Process_Spawn)
+{
+    // descriptors of the parent are not inherited by the adapter
+    int fds[2];
+    CHECK_CONDITION((::pipe(fds) == 0), "pipe failed");
+    wxString command;
+    command << "sh -c \"echo leaked >&" << fds[1] << "\"";
+    std::unique_ptr<dap::Process> process(dap::ExecuteProcess(command, ".", false));
+    for (int i = 0; i < 500 && process->IsAlive(); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    CHECK_CONDITION(!process->IsAlive(), "sh did not exit");
+    CHECK_CONDITION((process->GetExitCode() != 0), "the descriptor was inherited");
+    ::close(fds[1]);
+    char ch;
+    CHECK_NUMBER(::read(fds[0], &ch, 1), 0);
+    ::close(fds[0]);
+
+    // the child gets the pipes as its stdio
+    dap::StdoutTransport transport;
+    CHECK_CONDITION(transport.Execute({ "sh", "-c", "read line; echo \"$line\"; echo oops >&2" }), "failed to start sh");
+    CHECK_SIZE(transport.Send("hello\n"), 6);
+    dap::ByteBuffer buffer;
+    for (int i = 0; i < 100 && buffer.ReadableBytes() < 6; ++i) {
+        CHECK_CONDITION(transport.Read(buffer, 100), "read failed");
+    }
+    CHECK_CONDITION((buffer.View() == "hello\n"), "unexpected output");
+
+    // a missing executable is not reported as a running process
+    std::unique_ptr<dap::Process> missing(dap::ExecuteProcess("/no/such/adapter", ".", false));
+    for (int i = 0; i < 500 && missing->IsAlive(); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    CHECK_CONDITION(!missing->IsAlive(), "missing executable reported as alive");
+    return true;
+}
+
+TEST_FUNC(Check_Stdout_Transport_Send_Batch)
+{
+    dap::StdoutTransport transport;
+    CHECK_CONDITION(transport.Execute({ "cat" }), "failed to start cat");
+
+    // every byte value survives the trip, large payloads are written while the adapter consumes them
+    std::string binary;
+    for (int i = 0; i < 256; ++i) {
+        binary.push_back(static_cast<char>(i));
+    }
+    std::string large(1 << 20, 'x');
+    std::string_view buffers[] = { "Content-Length: 2\r\n\r\n{}", binary, "", large };
+    std::string expected;
+    for (std::string_view buffer : buffers) {
+        expected.append(buffer);
+    }
+
+    dap::ByteBuffer output;
+    std::thread reader([&]() {
+        for (int i = 0; i < 500 && output.ReadableBytes() < expected.size(); ++i) {
+            if (!transport.Read(output, 10)) {
+                break;
+            }
+        }
+    });
+    CHECK_SIZE(transport.SendBatch(buffers, 4), expected.size());
+    reader.join();
+    CHECK_SIZE(output.ReadableBytes(), expected.size());
+    CHECK_CONDITION((output.View() == expected), "output does not match the input");
+    return true;
+}
+
+TEST_FUNC(Check_Socket_Read_Into_Buffer)
+{
+    int fds[2];
+    CHECK_CONDITION((::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0), "socketpair failed");
+    dap::Socket socket(fds[0]);
+    dap::Socket peer(fds[1]);
+
+    dap::ByteBuffer buffer;
+    size_t bytes_read = 0;
+    CHECK_NUMBER(socket.Read(buffer, bytes_read), dap::Socket::kTimeout);
+    CHECK_SIZE(bytes_read, 0);
+
+    // a message larger than the default read size is received in one call
+    std::string payload(100 << 10, 'x');
+    payload.back() = 'y';
+    std::thread writer([&]() { peer.Send(payload); });
+    while (buffer.ReadableBytes() < payload.size()) {
+        CHECK_CONDITION((socket.SelectReadMS(1000) == dap::Socket::kSuccess), "timeout waiting for data");
+        socket.Read(buffer, bytes_read);
+    }
+    writer.join();
+    CHECK_CONDITION((buffer.View() == payload), "received data differs");
+
+    // the framing buffer takes the content over, swapped or appended
+    dap::JsonRPC rpc;
+    buffer.Clear();
+    buffer.Append("Content-Length: 2\r\n");
+    rpc.AppendBuffer(buffer);
+    CHECK_CONDITION(buffer.IsEmpty(), "buffer should be empty");
+    buffer.Append("\r\n{}");
+    rpc.AppendBuffer(buffer);
+    CHECK_CONDITION(buffer.IsEmpty(), "buffer should be empty");
+    int messages = 0;
+    rpc.ProcessBuffer([&](const dap::Json& json, wxObject*) { messages += json.IsObject(); }, nullptr);
+    CHECK_NUMBER(messages, 1);
+    return true;
+}
+#endif